@@ -40,22 +40,50 @@ void Engine::mainLoop()
 {
     while (!glfwWindowShouldClose(window->getWindow_ptr()))
     {
+        profiler->beginFrame();
 
         timer->updateDeltaTime();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        {
+            Profiler::Scope scope("camera");
+            updateCamera();
+        }
 
-
-
-        updateCamera();
-
+        {
+            Profiler::Scope scope("physics");
+            // physics runs on a fixed sim step, as many steps as the frame's sim time covers
+            while (timer->consumeSimStep())
+            {
+                bodies->step(timer->getSimStep());
+                collisions->step(*bodies);
+            }
+        }
+        {
+            Profiler::Scope scope("index");
+            // conics are evaluated once per frame however many steps ran, before anything reads positions
+            bodies->syncConics();
+            // once per frame, bodies that did not move cost a compare
+            geoIndex->update(*bodies);
+        }
+        // view, projection and camera position for every shader, once per frame
+        auto cam = getCurrentCamera();
+        Shader::updateCameraBlock(cam->getView(), cam->getProjection(), cam->getPosition());
         drawObjects();
-        drawConsole();
+        {
+            Profiler::Scope scope("console");
+            Profiler::GpuScope gpuScope("console");
+            drawConsole();
+        }
         //earth.render();
 
-        glfwSwapBuffers(window->getWindow_ptr());
+        {
+            Profiler::Scope scope("swap");
+            glfwSwapBuffers(window->getWindow_ptr());
+        }
         glfwPollEvents();
-
+        profiler->endFrame();
+        Trace::getInstance()->frame();
     }
     cleanup();
 }
@@ -3,6 +3,8 @@
 #define ENGINE_H
 
 #include <map>
+#include <iomanip>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -14,6 +16,7 @@
 #include "Cameras/Camera.hpp"
 #include "Utils/Shader.hpp"
 #include "static/wgs84.hpp"
+#include "static/atmosphere.hpp"
 #include "Objects/Object.hpp"
 #include "Objects/Ellipsoid.hpp"
 
@@ -22,7 +25,16 @@
 #include "Utils/Console.hpp"
 #include "Utils/Window.hpp"
 #include "Utils/Timer.hpp"
+#include "Utils/BodyStore.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/GravityField.hpp"
+#include "Utils/Collisions.hpp"
+#include "Utils/GeoIndex.hpp"
+#include "Utils/Events.hpp"
+#include "Utils/Profiler.hpp"
+#include "Utils/PerfCounters.hpp"
 #include "Objects/Rock.hpp"
+#include "Objects/DrawList.hpp"
 #define COMMAND_ARGS (const std::vector<std::string> &args)
 using namespace Utils;
 
@@ -46,21 +58,41 @@ public:
 
     void drawObjects()
     {
-        // Update and draw all flying objects
-        for (auto obj : Objects)
+        // Update all flying objects
         {
-            obj->update();
-            obj->draw();
+            Profiler::Scope scope("update");
+            for (auto obj : Objects)
+                obj->update();
         }
+        // collect their draws, then issue them sorted by state
+        Profiler::Scope scope("draw");
+        Profiler::GpuScope gpuScope("draw");
+        drawList.clear();
+        for (auto obj : Objects)
+            obj->collect(drawList);
+        drawList.submit();
     }
 
     void drawConsole()
     {
         auto cam = getCurrentCamera();
         console->updateObjectCount(Objects.size());
+        console->updateBodyCount(bodies->getActiveCount(), bodies->size() - bodies->getActiveCount());
         console->updateCameraYaw(cam->getYaw());
         console->updateCameraPitch(cam->getPitch());
         console->updateCameraPos(cam->getPosition());
+        if (console->debugInfo)
+        {
+            // rolling average and p99 of every profiled phase, in ms
+            std::vector<std::string> lines;
+            for (const Profiler::Stats &stats : profiler->getStats())
+            {
+                std::ostringstream oss;
+                oss << std::fixed << std::setprecision(2) << stats.name << ":" << stats.average << "|p99:" << stats.p99;
+                lines.push_back(oss.str());
+            }
+            console->updateProfile(lines);
+        }
         console->render();
     }
     void updateCamera()
@@ -101,11 +133,16 @@ private:
 
     static Engine *instance;
     Timer* timer = Timer::getInstance(); 
+    BodyStore* bodies = BodyStore::getInstance();
+    Collisions* collisions = Collisions::getInstance();
+    GeoIndex* geoIndex = GeoIndex::getInstance();
     Window* window = Window::getInstance();
     Console* console = Console::getInstance();
+    Profiler* profiler = Profiler::getInstance();
 
     std::map<std::string, std::shared_ptr<Shader>> shaders;
     std::vector<std::shared_ptr<Object>> Objects;
+    DrawList drawList;
     std::vector<std::shared_ptr<Camera>> cameraViews;
     int currentCameraViewIndex = 0;
 
@@ -279,6 +316,305 @@ private:
              }
              return oss.str();
          });
+         console->addCommand("setStep",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             try
+             {
+                 double step = std::stod(args.at(0));
+                 Timer::getInstance()->setSimStep(step);
+                 if(args.size()>=2)Timer::getInstance()->setMaxSimStepsPerFrame(std::stoi(args[1]));
+                 oss << "physics step "<<Timer::getInstance()->getSimStep()<<"s, max "
+                     <<Timer::getInstance()->getMaxSimStepsPerFrame()<<" steps per frame";
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("threads",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             JobSystem *jobs = JobSystem::getInstance();
+             try
+             {
+                 if(args.size()>=1)jobs->setThreadCount(std::stoul(args[0]));
+                 oss << "threads: "<<jobs->getThreadCount()
+                     <<" jobs run: "<<jobs->getJobsExecuted()
+                     <<" stolen: "<<jobs->getJobsStolen();
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("integrator",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             if(args.size()>=1){
+                 Integrator integrator;
+                 if(!Integrators::parse(args[0],integrator)){
+                     oss << "unknown integrator "<<args[0]<<", use "<<Integrators::names();
+                     return oss.str();
+                 }
+                 bodies->setDefaultIntegrator(integrator,true);
+             }
+             oss << "integrator: "<<Integrators::name(bodies->getDefaultIntegrator());
+             return oss.str();
+         });
+         console->addCommand("tol",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             try
+             {
+                 if(args.size()>=1){
+                     double tolerance = std::stod(args[0]);
+                     if(tolerance<=0.0)
+                         return std::string("tolerance must be positive");
+                     bodies->setTolerance(tolerance);
+                 }
+                 oss << "rk45 tolerance: "<<bodies->getTolerance();
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("gravity",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             GravityField *field = GravityField::getInstance();
+             try
+             {
+                 if(args.size()>=2 && args[0]=="load"){
+                     int degree = args.size()>=3 ? std::stoi(args[2]) : -1;
+                     if(!field->load(args[1],degree))
+                         return "could not load "+args[1];
+                 }
+                 else if(args.size()>=1)field->setDegree(std::stoi(args[0]));
+                 oss << "gravity field: "<<field->getSource()<<" degree "<<field->getDegree()
+                     <<"/"<<field->getMaxDegree();
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("atmosphere",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             try
+             {
+                 if(args.size()>=2 && args[0]=="high")
+                     Atmosphere::setHighAltitudeExtension(args[1]=="on");
+                 else if(args.size()>=1){
+                     double km = std::stod(args[0]);
+                     oss << "density at "<<km<<" km: "<<Atmosphere::density(km*1000.0)<<" kg/m3\n";
+                 }
+                 oss << "high altitude extension: "<<(Atmosphere::highAltitudeExtension()?"on":"off");
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("collisions",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             Collisions *collisions = Collisions::getInstance();
+             try
+             {
+                 if(args.size()>=1)collisions->setEnabled(args[0]=="on");
+                 if(args.size()>=2)collisions->setRestitution(std::stod(args[1]));
+                 oss << "collisions: "<<(collisions->isEnabled()?"on":"off")
+                     <<" restitution: "<<collisions->getRestitution()
+                     <<" cell: "<<collisions->getCellSize()
+                     <<" contacts: "<<collisions->getContacts().size();
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("kepler",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             try
+             {
+                 if(args.size()>=1)bodies->setKeplerAltitude(args[0]=="off" ? 0.0 : std::stod(args[0])*1000.0);
+                 if(bodies->getKeplerAltitude()<=0.0)
+                     oss << "kepler handoff: off";
+                 else
+                     oss << "kepler handoff above "<<bodies->getKeplerAltitude()/1000.0<<" km, "
+                         <<bodies->getConicCount()<<" bodies on a conic";
+                 double top = Atmosphere::highAltitudeExtension() ? Atmosphere::ExtensionTop : Atmosphere::LowerAtmosphereTop;
+                 if(bodies->getKeplerAltitude()>0.0 && bodies->getKeplerAltitude()<top)
+                     oss << "\nwarning: the atmosphere goes up to "<<top/1000.0<<" km, drag above the handoff is ignored";
+             }
+             catch (const std::exception &e)
+             {
+                 oss << e.what() << '\n';
+             }
+             return oss.str();
+         });
+         console->addCommand("sleep",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             if(args.size()>=1)bodies->setSleepEnabled(args[0]=="on");
+             oss << "sleep: "<<(bodies->isSleepEnabled()?"on":"off")
+                 <<" active: "<<bodies->getActiveCount()
+                 <<" sleeping: "<<bodies->size()-bodies->getActiveCount();
+             return oss.str();
+         });
+         console->addCommand("wake",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             size_t sleeping = bodies->size()-bodies->getActiveCount();
+             bodies->wakeAll();
+             oss << "woke "<<sleeping<<" bodies";
+             return oss.str();
+         });
+         console->addCommand("events",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             BodyStore *bodies = BodyStore::getInstance();
+             EventQueue *events = EventQueue::getInstance();
+             try
+             {
+                 if(args.size()>=1 && args[0]=="clear")bodies->clearAltitudeEvents();
+                 else if(args.size()>=1)bodies->addAltitudeEvent(std::stod(args[0])*1000.0);
+                 oss << "altitude events (km):";
+                 for(double meters : bodies->getAltitudeEvents())oss << " "<<meters/1000.0;
+                 oss << "\n"<<events->size()<<" queued, "<<events->getPushed()<<" found, "<<events->getDropped()<<" dropped";
+                 // the oldest few leave the queue
+                 BodyEvent event;
+                 for(int k=0;k<8 && events->poll(event);k++){
+                     oss << "\n t="<<event.time<<" #"<<event.body.id;
+                     if(event.kind==BodyEvent::Kind::Impact)oss << " impact";
+                     else oss << (event.rising?" up through ":" down through ")<<event.threshold/1000.0<<" km";
+                     oss << " at ("<<event.latitude<<","<<event.longitude<<") "
+                         <<event.speed/WGS84::UnitToMeterRatio<<" m/s";
+                 }
+             }
+             catch (const std::exception &e)
+             {
+                 oss << "events requires km or clear\n";
+             }
+             return oss.str();
+         });
+         console->addCommand("meshes",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             MeshRegistry *meshes = MeshRegistry::getInstance();
+             oss << meshes->size()<<" meshes, "<<meshes->getBufferCount()<<" GL buffers, "
+                 <<meshes->getUploadedBytes()/1024.0<<" KiB uploaded";
+             return oss.str();
+         });
+         console->addCommand("draws",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             const DrawList &list = Engine::getInstance()->drawList;
+             oss << list.size()<<" draws, "<<list.getProgramBinds()<<" program binds, "
+                 <<list.getMaterialBinds()<<" material binds, "<<list.getMeshBinds()<<" mesh binds";
+             return oss.str();
+         });
+         console->addCommand("prof",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             Profiler *profiler = Profiler::getInstance();
+             try
+             {
+                 if (args.size() > 0 && args.at(0) == "dump")
+                 {
+                     std::string path = args.size() > 1 ? args.at(1) : "profile.csv";
+                     if (!profiler->dump(path))
+                         return std::string("could not write ") + path;
+                     oss << std::min(profiler->getFrameCount(), Profiler::History)<<" frames written to "<<path;
+                     return oss.str();
+                 }
+                 if (args.size() > 0 && args.at(0) == "reset")
+                     profiler->reset();
+                 else if (args.size() > 0)
+                     throw std::invalid_argument(args.at(0));
+             }
+             catch (const std::exception &e)
+             {
+                 return std::string("Invalid argument, usage: prof [dump file | reset]");
+             }
+             // avg and p99 in ms over the kept frames
+             oss << std::fixed << std::setprecision(2);
+             for (const Profiler::Stats &stats : profiler->getStats())
+                 oss << stats.name<<" avg "<<stats.average<<" p99 "<<stats.p99<<"\n";
+             oss << profiler->getFrameCount()<<" frames";
+             return oss.str();
+         });
+         console->addCommand("trace",[]COMMAND_ARGS{
+             std::ostringstream oss;
+#ifdef EARTH_SIM_TRACE
+             Trace *trace = Trace::getInstance();
+             if (trace->isRecording())
+             {
+                 oss << "already tracing, "<<trace->getFramesLeft()<<" frames left";
+                 return oss.str();
+             }
+             try
+             {
+                 size_t frames = args.size() > 0 ? std::stoul(args.at(0)) : 300;
+                 std::string path = args.size() > 1 ? args.at(1) : "trace.json";
+                 trace->capture(frames, path);
+                 oss << "tracing the next "<<frames<<" frames to "<<path;
+             }
+             catch (const std::exception &e)
+             {
+                 oss << "Invalid argument, usage: trace [frames] [file]";
+             }
+#else
+             oss << "tracing is not built in, configure with EARTH_SIM_TRACE=ON";
+#endif
+             return oss.str();
+         });
+         console->addCommand("perf",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             PerfCounters *perf = PerfCounters::getInstance();
+             try
+             {
+                 if (args.size() > 0 && args.at(0) == "on")
+                     perf->setEnabled(true);
+                 else if (args.size() > 0 && args.at(0) == "off")
+                     perf->setEnabled(false);
+                 else if (args.size() > 0 && args.at(0) == "reset")
+                     perf->reset();
+                 else if (args.size() > 0)
+                     throw std::invalid_argument(args.at(0));
+             }
+             catch (const std::exception &e)
+             {
+                 return std::string("Invalid argument, usage: perf [on | off | reset]");
+             }
+             oss << "counters "<<(perf->isEnabled() ? "on" : "off")<<"\n"<<perf->report();
+             return oss.str();
+         });
+         console->addCommand("near",[]COMMAND_ARGS{
+             std::ostringstream oss;
+             try
+             {
+                 double lat = std::stod(args.at(0));
+                 double lon = std::stod(args.at(1));
+                 double km = std::stod(args.at(2));
+                 BodyStore *bodies = BodyStore::getInstance();
+                 std::vector<BodyHandle> found;
+                 GeoIndex::getInstance()->radius(lat,lon,km,found);
+                 oss << found.size()<<" bodies within "<<km<<" km of ("<<lat<<","<<lon<<")";
+                 // the first few, with the geodetic position they were indexed at
+                 for(size_t k=0;k<found.size() && k<8;k++){
+                     size_t i = bodies->indexOf(found[k]);
+                     oss << "\n #"<<found[k].id<<" lat "<<bodies->lon[i]<<" lon "<<bodies->lat[i]
+                         <<" alt "<<bodies->alt[i]/WGS84::UnitToMeterRatio/1000.0<<" km";
+                 }
+             }
+             catch (const std::exception &e)
+             {
+                 oss << "near requires lat lon km\n";
+             }
+             return oss.str();
+         });
         console->addCommand("p",[]COMMAND_ARGS{
             std::ostringstream oss;
             if(Timer::getTimeMultiplier()==0.f){
@@ -321,6 +657,23 @@ private:
              oss << "time -> print the uptime of app in seconds\n";
              oss << "g -> prints gravity vec at current position\n";
              oss << "c -> clear all objects\n";
+             oss << "setStep(s,max) -> fixed physics step in sim seconds\n";
+             oss << "threads(n) -> prints or sets the job system thread count\n";
+             oss << "integrator(name) -> euler|verlet|leapfrog|rk4|rk45 for all bodies\n";
+             oss << "tol(value) -> prints or sets the rk45 local error tolerance\n";
+             oss << "gravity(n | load file n) -> harmonic gravity degree, or loads a coefficient file\n";
+             oss << "atmosphere(km | high on/off) -> air density at km, toggles the layer above 86 km\n";
+             oss << "collisions(on/off, restitution) -> body collisions and last step contacts\n";
+             oss << "near(lat,lon,km) -> bodies within km of a lat/lon\n";
+             oss << "kepler(km | off) -> altitude above which orbiting bodies coast on a conic\n";
+             oss << "sleep(on/off) -> resting bodies drop out of the step, prints active/sleeping\n";
+             oss << "wake -> wakes every sleeping body\n";
+             oss << "events(km | clear) -> adds or clears altitude events, prints the oldest queued\n";
+             oss << "meshes -> shared meshes and the GPU buffers they hold\n";
+             oss << "draws -> draws and state changes of the last frame\n";
+             oss << "prof(dump file | reset) -> frame phase timings in ms, dump writes them as CSV\n";
+             oss << "trace(frames file) -> writes the next frames as a Chrome trace, default 300 to trace.json\n";
+             oss << "perf(on/off/reset) -> hardware counters of physics, geodesy and draws, IPC and misses per item\n";
              oss << "norm -> prints surface norm vec at current position";
              return oss.str();
          });
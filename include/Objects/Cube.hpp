@@ -1,5 +1,7 @@
 #pragma once
 #include "Object.hpp"
+#include "InstanceBatch.hpp"
+#include "DrawList.hpp"
 #include <vector>
 #include <GL/glew.h>
 
@@ -8,15 +10,19 @@ public:
     Cube( const glm::vec3& position)
     {
         setPosition(position);
-        loadObject();
         updateModelMatrix();
     }
 
+    void collect(DrawList &list) override {
+        // queued, the first cube of the frame stands for the batch in the draw list
+        instances().add(model, glm::vec3(1.0f, 0.5f, 0.2f));
+        if (instances().size() == 1)
+            list.add(*this, nullptr);
+    }
+
+    // one instanced draw call for the cubes queued since the last one
     void draw() override {
-        setShaderData();
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        instances().draw();
     }
 
     void update() override {
@@ -27,19 +33,21 @@ public:
     }
 
     void setShaderData() override {
-    auto shader = getShader("simple");
-    shader->use();
-    auto cam = getCurrentCamera();
-    shader->setMat4("model", model);
-    shader->setMat4("view", cam->getView());
-    shader->setMat4("projection", cam->getProjection());
+        // the camera comes from the shared Camera block, everything else with the instance
     }
 
+    char *shaderName() const override { return "simple_instanced"; }
+
 private:
+    // every cube shares the registry's cube mesh
+    static InstanceBatch &instances() {
+        static InstanceBatch *batch = new InstanceBatch(MeshRegistry::getInstance()->get("cube", buildMesh));
+        return *batch;
+    }
 
-    void loadObject() {
-        // Define the vertices and indices for a cube
-        vertices = {
+    static MeshData buildMesh() {
+        MeshData mesh;
+        mesh.vertices = {
             // Positions          
             -0.5f, -0.5f, -0.5f,  // Bottom-left
              0.5f, -0.5f, -0.5f,  // Bottom-right
@@ -51,7 +59,7 @@ private:
             -0.5f,  0.5f,  0.5f   // Top-left
         };
 
-        indices = {
+        mesh.indices = {
             0, 1, 2, 2, 3, 0, // Front face
             4, 5, 6, 6, 7, 4, // Back face
             4, 5, 1, 1, 0, 4, // Bottom face
@@ -60,23 +68,8 @@ private:
             1, 5, 6, 6, 2, 1  // Right face
         };
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        // position only
+        mesh.attributeSizes = {3};
+        return mesh;
     }
 };
@@ -0,0 +1,58 @@
+#include "DrawList.hpp"
+#include "Object.hpp"
+#include "Utils/PerfCounters.hpp"
+#include <algorithm>
+
+uint64_t DrawList::makeKey(GLuint program, GLuint vertexArray, uint32_t material)
+{
+    return (uint64_t(program & 0xFFFF) << 48) | (uint64_t(vertexArray & 0xFFFFFF) << 24) | uint64_t(material & 0xFFFFFF);
+}
+
+void DrawList::add(Object &object, const Mesh *mesh)
+{
+    Shader *shader = object.getShaderHandle();
+    uint32_t material = object.getMaterial();
+    items.push_back(RenderItem{makeKey(shader->getProgramID(), mesh ? mesh->VAO : 0, material), &object, shader, mesh, material});
+}
+
+void DrawList::submit()
+{
+    // stable, objects with the same state keep the order they were added in
+    std::stable_sort(items.begin(), items.end(), [](const RenderItem &a, const RenderItem &b) {
+        return a.key < b.key;
+    });
+
+    PerfCounters::Scope perf(PerfCounters::Draw, items.size());
+    programBinds = meshBinds = materialBinds = 0;
+    Shader *boundShader = nullptr;
+    const Mesh *boundMesh = nullptr;
+    uint32_t boundMaterial = 0;
+    for (const RenderItem &item : items)
+    {
+        bool newShader = item.shader != boundShader;
+        if (newShader)
+        {
+            item.shader->use();
+            boundShader = item.shader;
+            programBinds++;
+        }
+        if (newShader || item.material != boundMaterial)
+        {
+            item.object->bindMaterial(*item.shader);
+            boundMaterial = item.material;
+            materialBinds++;
+        }
+        if (item.mesh && item.mesh != boundMesh)
+        {
+            item.mesh->bind();
+            boundMesh = item.mesh;
+            meshBinds++;
+        }
+        item.object->setShaderData();
+        item.object->draw();
+        // the object bound its own vertex array
+        if (!item.mesh)
+            boundMesh = nullptr;
+    }
+    glBindVertexArray(0);
+}
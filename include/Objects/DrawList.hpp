@@ -0,0 +1,50 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Object;
+class Shader;
+struct Mesh;
+
+// one draw the list will issue, the key orders it by shader, then mesh, then material
+struct RenderItem {
+    uint64_t key;
+    Object *object;
+    Shader *shader;
+    const Mesh *mesh; // nullptr when the object binds its own vertex array (instance batches)
+    uint32_t material;
+};
+
+/*
+    the draws of one frame, sorted so state changes are only made when needed
+
+    objects add themselves after their update (Object::collect), submit()
+    sorts the items by key and walks them : glUseProgram only when the
+    shader changes, the material only when the shader or the material does,
+    the mesh VAO only when the mesh does. the object then sets its own
+    uniforms and issues the draw call with everything already bound.
+    the key packs the program (16 bits), the mesh VAO (24 bits) and the
+    material (24 bits), so equal state ends up next to each other
+*/
+class DrawList {
+public:
+    void clear() { items.clear(); }
+    void add(Object &object, const Mesh *mesh);
+    void submit();
+
+    size_t size() const { return items.size(); }
+    // state changes made by the last submit
+    size_t getProgramBinds() const { return programBinds; }
+    size_t getMeshBinds() const { return meshBinds; }
+    size_t getMaterialBinds() const { return materialBinds; }
+
+    static uint64_t makeKey(GLuint program, GLuint vertexArray, uint32_t material);
+
+private:
+    std::vector<RenderItem> items;
+    size_t programBinds = 0;
+    size_t meshBinds = 0;
+    size_t materialBinds = 0;
+};
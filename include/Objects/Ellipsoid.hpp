@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include <vector>
 #include <GL/glew.h>
 #include <static/wgs84.hpp>
@@ -11,17 +12,16 @@ public:
     Ellipsoid(const glm::vec3 &position, int stacks, int slices)
     {
         setPosition(position);
-        loadObject(stacks, slices);
+        // built once per resolution, a new ellipsoid of the same size shares it
+        mesh = MeshRegistry::getInstance()->get("ellipsoid " + std::to_string(stacks) + "x" + std::to_string(slices),
+                                                [stacks, slices] { return buildMesh(stacks, slices); });
         updateModelMatrix();
     }
 
     void draw() override
     {
-        setShaderData();
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size() / 3);
+        mesh->draw();
         checkGLError("draw");
-        glBindVertexArray(0);
     }
 
     void update() override
@@ -32,20 +32,21 @@ public:
 
     void setShaderData() override
     {
-        auto shader = getShader("simple");
-        shader->use();
-        auto cam = getCurrentCamera();
-        
-        shader->setMat4("model", model);
-        shader->setMat4("view", cam->getView());
-        shader->setMat4("projection", cam->getProjection());
+        // the camera comes from the shared Camera block
+        // the location comes from the shader's table filled at link time, so it follows a reload
+        getShaderHandle()->setMat4("model", model);
     }
 
+    char *shaderName() const override { return "simple"; }
+
 private:
 
-    void loadObject(int stacks, int slices)
+    static MeshData buildMesh(int stacks, int slices)
     {
         // Generate ellipsoid vertices
+        MeshData mesh;
+        mesh.primitive = GL_TRIANGLE_STRIP;
+        mesh.attributeSizes = {3};
 
         for (int i = 0; i <= stacks; ++i) {
             float theta = i * M_PI / stacks;
@@ -69,24 +70,11 @@ private:
                 yr *= WGS84::A;
                 zr *= WGS84::B;
 
-                vertices.push_back(xr);
-                vertices.push_back(yr);
-                vertices.push_back(zr);
+                mesh.vertices.push_back(xr);
+                mesh.vertices.push_back(yr);
+                mesh.vertices.push_back(zr);
             }
         }
-
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        return mesh;
     }
 };
\ No newline at end of file
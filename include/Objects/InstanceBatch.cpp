@@ -0,0 +1,49 @@
+#include "InstanceBatch.hpp"
+#include <algorithm>
+#include <cstddef>
+
+InstanceBatch::InstanceBatch(std::shared_ptr<const Mesh> mesh) : mesh(mesh)
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(VAO);
+    mesh->bindAttributes();
+
+    // a mat4 attribute takes 4 locations, one column each
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(ModelLocation + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void *)(offsetof(Instance, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(ModelLocation + column);
+        glVertexAttribDivisor(ModelLocation + column, 1);
+    }
+    glVertexAttribPointer(ColourLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, colour));
+    glEnableVertexAttribArray(ColourLocation);
+    glVertexAttribDivisor(ColourLocation, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBatch::draw()
+{
+    if (instances.empty())
+        return;
+
+    // a fresh store every frame (orphaning) so the driver never waits on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    capacity = std::max(instances.size(), capacity);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(VAO);
+    GLsizei count = static_cast<GLsizei>(instances.size());
+    if (mesh->indexed())
+        glDrawElementsInstanced(mesh->primitive, mesh->count, GL_UNSIGNED_INT, 0, count);
+    else
+        glDrawArraysInstanced(mesh->primitive, 0, mesh->count, count);
+    glBindVertexArray(0);
+    instances.clear();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "Mesh.hpp"
+
+/*
+    one mesh drawn for many objects with a single glDrawElementsInstanced
+
+    the mesh comes from the MeshRegistry, the batch only adds a VAO that also
+    reads its instance buffer. objects queue their model matrix and colour
+    when they are drawn, draw() streams the queued instances into the
+    instance buffer (matrix columns at locations 2 to 5, colour at 6,
+    advancing once per instance) and issues one call for all of them with
+    whatever shader is in use
+*/
+class InstanceBatch {
+public:
+    explicit InstanceBatch(std::shared_ptr<const Mesh> mesh);
+
+    void add(const glm::mat4 &model, const glm::vec3 &colour) { instances.push_back(Instance{model, colour}); }
+    // draws the queued instances and empties the batch
+    void draw();
+    size_t size() const { return instances.size(); }
+
+    static constexpr GLuint ModelLocation = 2;
+    static constexpr GLuint ColourLocation = 6;
+
+private:
+    struct Instance {
+        glm::mat4 model;
+        glm::vec3 colour;
+    };
+
+    std::shared_ptr<const Mesh> mesh;
+    GLuint VAO = 0, instanceVBO = 0;
+    // instances the GPU buffer has room for
+    size_t capacity = 0;
+    std::vector<Instance> instances;
+};
@@ -0,0 +1,74 @@
+#include "Mesh.hpp"
+
+MeshRegistry *MeshRegistry::instance = nullptr;
+
+void Mesh::bindAttributes() const
+{
+    int stride = 0;
+    for (int size : attributeSizes)
+        stride += size;
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    int offset = 0;
+    for (GLuint location = 0; location < attributeSizes.size(); location++)
+    {
+        glVertexAttribPointer(location, attributeSizes[location], GL_FLOAT, GL_FALSE, stride * sizeof(float),
+                              (void *)(offset * sizeof(float)));
+        glEnableVertexAttribArray(location);
+        offset += attributeSizes[location];
+    }
+    if (indexed())
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+}
+
+void Mesh::draw() const
+{
+    if (indexed())
+        glDrawElements(primitive, count, GL_UNSIGNED_INT, 0);
+    else
+        glDrawArrays(primitive, 0, count);
+}
+
+std::shared_ptr<const Mesh> MeshRegistry::get(const std::string &key, const std::function<MeshData()> &build)
+{
+    auto it = meshes.find(key);
+    if (it != meshes.end())
+        return it->second;
+
+    MeshData data = build();
+    auto mesh = std::make_shared<Mesh>();
+    mesh->primitive = data.primitive;
+    mesh->attributeSizes = data.attributeSizes;
+
+    // the element buffer binding belongs to the VAO, so it is bound first
+    glGenVertexArrays(1, &mesh->VAO);
+    glBindVertexArray(mesh->VAO);
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(float), data.vertices.data(), GL_STATIC_DRAW);
+    uploadedBytes += data.vertices.size() * sizeof(float);
+    bufferCount++;
+    if (!data.indices.empty())
+    {
+        glGenBuffers(1, &mesh->EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
+        uploadedBytes += data.indices.size() * sizeof(unsigned int);
+        bufferCount++;
+        mesh->count = static_cast<GLsizei>(data.indices.size());
+    }
+    else
+    {
+        int stride = 0;
+        for (int size : data.attributeSizes)
+            stride += size;
+        mesh->count = static_cast<GLsizei>(data.vertices.size() / stride);
+    }
+
+    mesh->bindAttributes();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    meshes[key] = mesh;
+    return mesh;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <GL/glew.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// CPU side of a mesh, it only lives until the upload
+struct MeshData {
+    std::vector<float> vertices;       // interleaved attributes
+    std::vector<unsigned int> indices; // empty = drawn as plain vertex arrays
+    std::vector<int> attributeSizes;   // floats of each attribute, from location 0
+    GLenum primitive = GL_TRIANGLES;
+};
+
+// geometry on the GPU, shared by every object that draws it
+struct Mesh {
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    GLenum primitive = GL_TRIANGLES;
+    GLsizei count = 0; // indices, or vertices when there is no EBO
+    std::vector<int> attributeSizes;
+
+    bool indexed() const { return EBO != 0; }
+    // points the vertex attributes and the EBO of the bound VAO at this mesh
+    void bindAttributes() const;
+    void bind() const { glBindVertexArray(VAO); }
+    // issues the draw call, the VAO has to be bound already (see DrawList)
+    void draw() const;
+};
+
+/*
+    every mesh the objects draw, built once per key
+
+    the key names the mesh and the parameters it was built from ("rock",
+    "ellipsoid 100x100"), get() only calls build the first time a key is
+    asked for, uploads the result and lets the CPU copy go. objects keep
+    the returned pointer, so spawning more of them adds no geometry
+*/
+class MeshRegistry {
+public:
+        MeshRegistry(const MeshRegistry &obj) = delete;
+        static MeshRegistry *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new MeshRegistry();
+            return instance;
+        }
+
+    std::shared_ptr<const Mesh> get(const std::string &key, const std::function<MeshData()> &build);
+
+    size_t size() const { return meshes.size(); }
+    // GL buffers and bytes held by all meshes
+    size_t getBufferCount() const { return bufferCount; }
+    size_t getUploadedBytes() const { return uploadedBytes; }
+
+private:
+    static MeshRegistry *instance;
+    MeshRegistry() = default;
+
+    std::map<std::string, std::shared_ptr<Mesh>> meshes;
+    size_t bufferCount = 0;
+    size_t uploadedBytes = 0;
+};
@@ -1,5 +1,14 @@
 #include "Object.hpp"
 #include "Engine.hpp"
+#include "DrawList.hpp"
+
+    Object::~Object(){
+            bodies->destroy(body);
+    };
+
+    void Object::collect(DrawList &list){
+            list.add(*this, mesh.get());
+    };
 
     std::shared_ptr<Shader> Object::getShader(char* name){
             return Engine::getInstance()->getShader(name);
@@ -11,45 +11,53 @@
 #include "Utils/Timer.hpp"
 #include "Cameras/Camera.hpp"
 #include "Utils/Physics.hpp"
+#include "Utils/BodyStore.hpp"
+#include "Objects/Mesh.hpp"
+
+class DrawList;
 
 class Object {
 public:
-    virtual ~Object() = default;
+    virtual ~Object();
 
-    virtual void draw() = 0;   // method for drawing the object
+    virtual void draw() = 0;   // issues the draw call, shader, material and mesh are bound by the DrawList
     virtual void update() = 0; // method for updating the object
-    virtual void setShaderData() = 0;
-
+    virtual void setShaderData() = 0; // uniforms of this object only, like its model matrix
+    virtual char *shaderName() const = 0;
+
+    // adds what the object draws this frame to the list, by default one item for its mesh
+    virtual void collect(DrawList &list);
+    // uniforms shared by every object of the same material, set once per run of them
+    virtual uint32_t getMaterial() const { return 0; }
+    virtual void bindMaterial(Shader &) {}
+
+    // the shader is looked up by name the first time and kept
+    Shader *getShaderHandle() {
+        if (!shaderHandle)
+            shaderHandle = getShader(shaderName()).get();
+        return shaderHandle;
+    }
 
 
 protected:
 
-    GLuint VAO, VBO, EBO = 0;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    // geometry from the MeshRegistry, shared with every object of the same shape
+    std::shared_ptr<const Mesh> mesh;
 
-    std::shared_ptr<Shader> getShader(char *name);
-    std::shared_ptr<Camera> getCurrentCamera();
+    static std::shared_ptr<Shader> getShader(char *name);
+    static std::shared_ptr<Camera> getCurrentCamera();
 
 
     // Function to update the model matrix based on position and orientation
+    // the position is interpolated between the last two physics steps for smooth motion
+    // a sleeping body does not move, its resting matrix is kept until it falls asleep again
     void updateModelMatrix() {
-        model = glm::mat4_cast(orientation); // Converts quaternion to rotation matrix
-        model = glm::translate(model, glm::vec3(position.getECEF()));
-    }
-
-    // Function to calculate and apply all forces
-    void calculateAndApplyForces(double deltaTime) {
-        if(position.getAltitude()<=0){
-            position.setVelocity(glm::vec3(0.f));
-            updateModelMatrix();
+        double sleptAt = bodies->isSleeping(body) ? bodies->getSleptAt(body) : -1.0;
+        if (sleptAt >= 0.0 && sleptAt == restingSince)
             return;
-        }
-        for (const auto &force : forces) {
-            force->apply(position, deltaTime);
-        }
-        position.calculateAndApplyForces(mass, deltaTime);
-        updateModelMatrix();
+        restingSince = sleptAt;
+        model = glm::mat4_cast(orientation); // Converts quaternion to rotation matrix
+        model = glm::translate(model, bodies->getInterpolatedECEF(body, timer->getInterpolationAlpha()));
     }
 
     void checkGLError(const std::string &context) {
@@ -61,43 +69,62 @@ protected:
 
         // Setters for position in ECEF courdinets 
     void setPosition(const glm::vec3 &pos) {
-        position = Position(pos);
+        bodies->setECEF(body, pos);
     }
 
     void setVelocity(const glm::vec3 &vel) {
-        position.setVelocity(vel);
+        bodies->setVelocity(body, vel);
     }
 
     void setOrientation(const glm::quat &orient) {
         orientation = orient;
+        restingSince = -1.0;
     }
 
     void setMass(double newMass) {
-        mass = newMass;
+        bodies->setMass(body, newMass);
+    }
+
+    void setRadius(double newRadius) {
+        bodies->setRadius(body, newRadius);
+    }
+
+    void setIntegrator(Integrator integrator) {
+        bodies->setIntegrator(body, integrator);
     }
 
     // Getters for position, velocity, and orientation
     const glm::vec3 getPosition() const {
-        return position.getECEF();
+        return bodies->getECEF(body);
     }
 
     const glm::vec3 getVelocity() const {
-        return position.getVelocity();
+        return bodies->getVelocity(body);
+    }
+
+    double getMass() const {
+        return bodies->getMass(body);
     }
 
     const glm::quat &getOrientation() const { return orientation; }
     const glm::mat4 &getModelMatrix() const { return model; }
 
 
-    // Method to add a force to the object
-    void addForce(std::unique_ptr<Force> force) {
-        forces.push_back(std::move(force));
+    // Method to set the forces acting on the object
+    void setForceModel(const ForceModel &model) {
+        bodies->setForceModel(body, model);
     }
 
     Utils::Timer *timer = Utils::Timer::getInstance();
-    Position position{0.0, 0.0, 0.0}; // Initialized with default coordinates
+    BodyStore *bodies = BodyStore::getInstance();
+    // Physical state lives in the BodyStore, default mass of 1 can be set differently if needed
+    BodyHandle body = bodies->create(glm::vec3(0.f), glm::vec3(0.f), 1.0);
     glm::quat orientation;
     glm::mat4 model;
-    double mass = 1.0f; // Assuming a default mass, can be set differently if needed
-    std::vector<std::unique_ptr<Force>> forces;
+    // sleptAt of the sleep the model matrix was built in, -1 while it follows the body
+    double restingSince = -1.0;
+
+private:
+    // owned by the Engine's shader cache, which outlives the objects
+    Shader *shaderHandle = nullptr;
 };
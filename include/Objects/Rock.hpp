@@ -1,12 +1,14 @@
 #pragma once
 #include "Objects/Object.hpp"
+#include "Objects/RockForces.hpp"
+#include "Objects/InstanceBatch.hpp"
+#include "Objects/DrawList.hpp"
 
 class Rock : public Object {
 public:
     Rock()
     {
         orientation = glm::quat(1.0, 0.0, 0.0, 0.0);
-        loadObject();
         setForces();
     }
 
@@ -15,46 +17,57 @@ public:
         setPosition(position);
         setVelocity(initialVelocity);
         setOrientation(initialOrientation);
-        loadObject();
         setForces();
         updateModelMatrix();
     }
 
+    void collect(DrawList &list) override {
+        // queued, the first rock of the frame stands for the batch in the draw list
+        instances().add(model, glm::vec3(0.3f, 0.1f, 0.1f));
+        if (instances().size() == 1)
+            list.add(*this, nullptr);
+    }
+
+    // one instanced draw call for the rocks queued since the last one
     void draw() override {
-        // Bind VAO and draw the rock object
-        setShaderData();
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        instances().draw();
     }
 
     void setShaderData() override {
-        auto shader = getShader("phisical");
-        shader->use();
-        auto cam = getCurrentCamera();
-        shader->setMat4("model", model);
-        shader->setMat4("view", cam->getView());
-        shader->setMat4("projection", cam->getProjection());
-        shader->setVec3("objectColor", glm::vec3(0.3f, 0.1f, 0.1f)); // Example color
-        shader->setVec3("lightColor", glm::vec3(1.0f));
-        shader->setVec3("lightPos", glm::vec3(100.f,500.f,100.f));
-        shader->setVec3("viewPos", cam->getPosition());
+        // the model matrix and colour come with the instance
+    }
+
+    char *shaderName() const override { return "phisical_instanced"; }
+
+    uint32_t getMaterial() const override { return Material; }
+
+    // uniforms shared by every rock, the camera comes from the shared Camera block
+    void bindMaterial(Shader &shader) override {
+        shader.setVec3("lightColor", glm::vec3(1.0f));
+        shader.setVec3("lightPos", glm::vec3(100.f,500.f,100.f));
     }
 
     void update() override {
-        double deltaTime = timer->getDeltaSimTime();
-        calculateAndApplyForces(deltaTime);
+        // physics is stepped for all bodies at once by the BodyStore
+        updateModelMatrix();
     }
 
 private:
+    static constexpr uint32_t Material = 1;
+
     void setForces(){
-        addForce(std::make_unique<GravityForce>(mass));
-        //addForce(std::make_unique<DragForce>(mass, 0.47));
+        RockForces::set(*bodies, body);
     }
 
-    void loadObject() {
-        // Define the vertices and indices for the rock
-        vertices = {
+    // every rock shares the registry's rock mesh
+    static InstanceBatch &instances() {
+        static InstanceBatch *batch = new InstanceBatch(MeshRegistry::getInstance()->get("rock", buildMesh));
+        return *batch;
+    }
+
+    static MeshData buildMesh() {
+        MeshData mesh;
+        mesh.vertices = {
             // positions          // normals       
             // front face
             -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  
@@ -68,7 +81,7 @@ private:
             -0.5f,  0.5f, -0.5f,  0.0f, 0.0f, -1.0f,         
         };
 
-        indices = {
+        mesh.indices = {
             // front face
             0, 1, 2,
             2, 3, 0,
@@ -89,29 +102,8 @@ private:
             5, 4, 0
         };
 
-        // Generate and bind VAO
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
-
-        // Generate and bind VBO
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        // Generate and bind EBO
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // Normal attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        // Unbind VAO
-        glBindVertexArray(0);
+        // position and normal
+        mesh.attributeSizes = {3, 3};
+        return mesh;
     }
 };
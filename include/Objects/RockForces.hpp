@@ -0,0 +1,16 @@
+#pragma once
+#include "Utils/BodyStore.hpp"
+
+// Force stack of a Rock, kept free of GL so render-less runs step the same physics
+namespace RockForces {
+    inline ForceModel model()
+    {
+        return ForceModels::Ballistic(GravityForce());
+        //return ForceModels::Atmospheric(GravityForce(), DragForce(0.47));
+    }
+
+    inline void set(BodyStore &bodies, BodyHandle body)
+    {
+        bodies.setForceModel(body, model());
+    }
+};
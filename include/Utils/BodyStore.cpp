@@ -0,0 +1,630 @@
+#include "Utils/BodyStore.hpp"
+#include "Utils/Events.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/Trace.hpp"
+#include "Utils/PerfCounters.hpp"
+#include <algorithm>
+#include <cmath>
+
+BodyStore *BodyStore::instance = nullptr;
+
+namespace {
+    // state at fraction s of a step of length h, on the cubic Hermite through both ends
+    void hermite(const double p0[3], const double v0[3], const double p1[3], const double v1[3], double h, double s,
+                 double p[3], double v[3])
+    {
+        double s2 = s * s, s3 = s2 * s;
+        double h00 = 2 * s3 - 3 * s2 + 1, h10 = s3 - 2 * s2 + s, h01 = 3 * s2 - 2 * s3, h11 = s3 - s2;
+        double d00 = 6 * s2 - 6 * s, d10 = 3 * s2 - 4 * s + 1, d11 = 3 * s2 - 2 * s;
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = h00 * p0[k] + h10 * h * v0[k] + h01 * p1[k] + h11 * h * v1[k];
+            v[k] = d00 * (p0[k] - p1[k]) / h + d10 * v0[k] + d11 * v1[k];
+        }
+    }
+
+    double altitudeAt(const double p[3])
+    {
+        double lon, lat, height;
+        WGS84::toGeodetic(&p[0], &p[1], &p[2], &lon, &lat, &height, 1);
+        return height;
+    }
+
+    // fraction of the step where g goes from ga (at 0) to the other sign (gb, at 1), by Illinois false
+    // position. returns the end of the final bracket on gb's side, the state there is already across
+    template <class Fn>
+    double findCrossing(Fn g, double ga, double gb)
+    {
+        double a = 0.0, b = 1.0;
+        int side = 0;
+        for (int iteration = 0; iteration < 100 && b - a > 1e-12; iteration++)
+        {
+            double s = std::clamp((a * gb - b * ga) / (gb - ga), a, b);
+            double gs = g(s);
+            if ((gs > 0) == (gb > 0))
+            {
+                b = s;
+                gb = gs;
+                // the same end moved twice, halve the other one so it moves too
+                if (side == -1)
+                    ga /= 2;
+                side = -1;
+            }
+            else
+            {
+                a = s;
+                ga = gs;
+                if (side == 1)
+                    gb /= 2;
+                side = 1;
+            }
+        }
+        return b;
+    }
+}
+
+BodyHandle BodyStore::create(const glm::vec3 &ecef, const glm::vec3 &velocity, double bodyMass)
+{
+    BodyHandle handle;
+    if (!freeIds.empty())
+    {
+        handle.id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        handle.id = slotOf.size();
+        slotOf.push_back(0);
+    }
+
+    uint32_t index = x.size();
+    slotOf[handle.id] = index;
+
+    forEachColumn([](auto &column) { column.emplace_back(); });
+    idOf[index] = handle.id;
+    integrator[index] = defaultIntegrator;
+
+    x[index] = prevX[index] = ecef.x;
+    y[index] = prevY[index] = ecef.y;
+    z[index] = prevZ[index] = ecef.z;
+    vx[index] = velocity.x;
+    vy[index] = velocity.y;
+    vz[index] = velocity.z;
+    mass[index] = bodyMass;
+    radius[index] = defaultRadius;
+
+    updateGeodetic(index);
+
+    // new bodies start awake, in front of the sleeping ones
+    if (activeCount < index)
+    {
+        swapBodies(index, activeCount);
+        sleepVersion++;
+    }
+    activeCount++;
+    return handle;
+}
+
+void BodyStore::destroy(BodyHandle handle)
+{
+    if (!handle.valid() || handle.id >= slotOf.size())
+        return;
+
+    uint32_t index = slotOf[handle.id];
+    // an awake body first trades places with the last awake one, so the hole is at the start of the sleepers
+    if (index < activeCount)
+    {
+        swapBodies(index, activeCount - 1);
+        index = --activeCount;
+    }
+    sleepVersion++;
+
+    // move the last body into the freed slot so the columns stay dense
+    uint32_t last = x.size() - 1;
+    forEachColumn([index, last](auto &column) {
+        if (index != last)
+            column[index] = std::move(column[last]);
+        column.pop_back();
+    });
+    if (index != last)
+        slotOf[idOf[index]] = index;
+
+    freeIds.push_back(handle.id);
+}
+
+void BodyStore::clear()
+{
+    forEachColumn([](auto &column) { column.clear(); });
+    slotOf.clear();
+    freeIds.clear();
+    activeCount = 0;
+    sleepVersion++;
+}
+
+size_t BodyStore::memoryUsage() const
+{
+    size_t bytes = 0;
+    forEachColumn([&bytes](const auto &column) { bytes += column.capacity() * sizeof(column[0]); });
+    return bytes + (slotOf.capacity() + freeIds.capacity()) * sizeof(uint32_t);
+}
+
+void BodyStore::reserve(size_t count)
+{
+    forEachColumn([count](auto &column) { column.reserve(count); });
+    slotOf.reserve(count);
+}
+
+void BodyStore::setForceModel(BodyHandle handle, const ForceModel &model)
+{
+    wake(handle);
+    size_t i = indexOf(handle);
+    if (onConic[i])
+        leaveConic(i);
+    forceModel[i] = model;
+    forceCurrent[i] = 0;
+}
+
+void BodyStore::setIntegrator(BodyHandle handle, Integrator scheme)
+{
+    integrator[indexOf(handle)] = scheme;
+}
+
+void BodyStore::setDefaultIntegrator(Integrator scheme, bool applyToAll)
+{
+    defaultIntegrator = scheme;
+    if (applyToAll)
+        std::fill(integrator.begin(), integrator.end(), scheme);
+}
+
+void BodyStore::step(double deltaTime)
+{
+    TRACE_SCOPE("body step");
+    Utils::JobSystem::getInstance()->parallelFor(activeCount, stepGrain, [this, deltaTime](size_t begin, size_t end) {
+        TRACE_SCOPE("step slice");
+        PerfCounters::Scope perf(PerfCounters::Physics, end - begin);
+        accumulateForces(begin, end, deltaTime);
+        integrate(begin, end, deltaTime);
+        updateSteppedGeodetic(begin, end);
+        thread_local std::vector<BodyEvent> found;
+        found.clear();
+        locateEvents(begin, end, deltaTime, found);
+        EventQueue::getInstance()->stage(found);
+        enterConics(begin, end, time + deltaTime);
+    });
+    EventQueue::getInstance()->commit();
+    time += deltaTime;
+    lastStep = deltaTime;
+    if (sleepEnabled)
+        settle();
+}
+
+void BodyStore::locateEvents(size_t begin, size_t end, double deltaTime, std::vector<BodyEvent> &found)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        if (onConic[i] || prevAlt[i] <= 0)
+            continue;
+        bool impact = alt[i] <= 0;
+        if (!impact && altitudeEvents.empty())
+            continue;
+
+        const double p0[3] = {prevX[i], prevY[i], prevZ[i]}, v0[3] = {prevVx[i], prevVy[i], prevVz[i]};
+        const double p1[3] = {x[i], y[i], z[i]}, v1[3] = {vx[i], vy[i], vz[i]};
+        auto heightAt = [&](double s) {
+            double p[3], v[3];
+            hermite(p0, v0, p1, v1, deltaTime, s, p, v);
+            return altitudeAt(p);
+        };
+        auto record = [&](BodyEvent::Kind kind, double threshold, double s, bool rising) {
+            BodyEvent event;
+            event.kind = kind;
+            event.rising = rising;
+            event.body = handleOf(i);
+            event.time = time + s * deltaTime;
+            event.threshold = threshold;
+            double p[3], v[3];
+            hermite(p0, v0, p1, v1, deltaTime, s, p, v);
+            event.x = p[0];
+            event.y = p[1];
+            event.z = p[2];
+            double height;
+            WGS84::toGeodetic(&p[0], &p[1], &p[2], &event.longitude, &event.latitude, &height, 1);
+            event.speed = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            found.push_back(event);
+        };
+
+        double impactAt = 1.0;
+        if (impact)
+            impactAt = findCrossing(heightAt, prevAlt[i], alt[i]);
+        for (double threshold : altitudeEvents)
+        {
+            double h = threshold * WGS84::UnitToMeterRatio;
+            double ga = prevAlt[i] - h, gb = alt[i] - h;
+            if ((ga > 0) == (gb > 0))
+                continue;
+            double s = findCrossing([&](double s) { return heightAt(s) - h; }, ga, gb);
+            // thresholds the path only crossed under ground never happened
+            if (!impact || s <= impactAt)
+                record(BodyEvent::Kind::Altitude, threshold, s, gb > 0);
+        }
+        if (!impact)
+            continue;
+
+        // the body stops where it reached the ground instead of wherever the step left it
+        record(BodyEvent::Kind::Impact, 0.0, impactAt, false);
+        double p[3], v[3];
+        hermite(p0, v0, p1, v1, deltaTime, impactAt, p, v);
+        x[i] = p[0];
+        y[i] = p[1];
+        z[i] = p[2];
+        vx[i] = vy[i] = vz[i] = 0.0;
+        forceCurrent[i] = 0;
+        updateGeodetic(i);
+        alt[i] = std::min(alt[i], 0.0);
+    }
+}
+
+void BodyStore::addAltitudeEvent(double meters)
+{
+    auto it = std::lower_bound(altitudeEvents.begin(), altitudeEvents.end(), meters);
+    if (it == altitudeEvents.end() || *it != meters)
+        altitudeEvents.insert(it, meters);
+}
+
+void BodyStore::removeAltitudeEvent(double meters)
+{
+    auto it = std::lower_bound(altitudeEvents.begin(), altitudeEvents.end(), meters);
+    if (it != altitudeEvents.end() && *it == meters)
+        altitudeEvents.erase(it);
+}
+
+void BodyStore::swapBodies(size_t a, size_t b)
+{
+    if (a == b)
+        return;
+    forEachColumn([a, b](auto &column) { std::swap(column[a], column[b]); });
+    slotOf[idOf[a]] = a;
+    slotOf[idOf[b]] = b;
+}
+
+bool BodyStore::isResting(size_t i) const
+{
+    if (alt[i] <= 0)
+        return true;
+    return !hasForces(forceModel[i]) && vx[i] == 0.0 && vy[i] == 0.0 && vz[i] == 0.0;
+}
+
+void BodyStore::settle()
+{
+    // walking down, the awake body swapped into i has been looked at already
+    for (size_t i = activeCount; i-- > 0;)
+    {
+        if (!isResting(i))
+            continue;
+        prevX[i] = x[i];
+        prevY[i] = y[i];
+        prevZ[i] = z[i];
+        forceCurrent[i] = 0;
+        sleptAt[i] = time;
+        swapBodies(i, --activeCount);
+        sleepVersion++;
+    }
+}
+
+void BodyStore::wake(BodyHandle handle)
+{
+    size_t i = indexOf(handle);
+    if (i < activeCount)
+        return;
+    swapBodies(i, activeCount++);
+    sleepVersion++;
+}
+
+void BodyStore::wakeAll()
+{
+    // the sleepers already sit right after the awake bodies
+    activeCount = size();
+    sleepVersion++;
+}
+
+void BodyStore::setSleepEnabled(bool enabled)
+{
+    sleepEnabled = enabled;
+    if (!enabled)
+        wakeAll();
+}
+
+void BodyStore::setKeplerAltitude(double meters)
+{
+    keplerAltitude = meters;
+    // bodies coasting below the new altitude go back to stepping, the others re-enter on their own
+    for (size_t i = 0; i < size(); i++)
+        if (onConic[i])
+            leaveConic(i);
+}
+
+void BodyStore::enterConics(size_t begin, size_t end, double epoch)
+{
+    if (keplerAltitude <= 0.0)
+        return;
+    // geodetic altitude is never below radius - A, so past this radius the whole conic check is geocentric
+    double radius = WGS84::A + keplerAltitude * WGS84::UnitToMeterRatio;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (onConic[i] || alt[i] <= 0 || !followsConic(forceModel[i]))
+            continue;
+        if (x[i] * x[i] + y[i] * y[i] + z[i] * z[i] <= radius * radius)
+            continue;
+
+        Kepler::Orbit &conic = orbit[i];
+        conic.epoch = epoch;
+        conic.r[0] = x[i];
+        conic.r[1] = y[i];
+        conic.r[2] = z[i];
+        conic.v[0] = vx[i];
+        conic.v[1] = vy[i];
+        conic.v[2] = vz[i];
+        conic.wake = epoch + Kepler::timeToRadius(conic.r, conic.v, WGS84::GM, radius);
+        onConic[i] = 1;
+    }
+}
+
+void BodyStore::leaveConic(size_t i)
+{
+    const Kepler::Orbit &conic = orbit[i];
+    double r[3], v[3];
+    Kepler::propagate(conic.r, conic.v, WGS84::GM, time - conic.epoch, r, v);
+    x[i] = prevX[i] = r[0];
+    y[i] = prevY[i] = r[1];
+    z[i] = prevZ[i] = r[2];
+    vx[i] = v[0];
+    vy[i] = v[1];
+    vz[i] = v[2];
+    onConic[i] = 0;
+    forceCurrent[i] = 0;
+    stepSize[i] = 0.0;
+    updateGeodetic(i);
+}
+
+void BodyStore::syncConics()
+{
+    TRACE_SCOPE("sync conics");
+    // conics never sleep, the awake bodies are enough
+    Utils::JobSystem::getInstance()->parallelFor(activeCount, stepGrain, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            if (!onConic[i])
+                continue;
+            // the previous step too, so rendering interpolates like for stepped bodies
+            const Kepler::Orbit &conic = orbit[i];
+            double r[3], v[3], previous[3], previousVelocity[3];
+            Kepler::propagate(conic.r, conic.v, WGS84::GM, time - conic.epoch, r, v);
+            Kepler::propagate(conic.r, conic.v, WGS84::GM, time - lastStep - conic.epoch, previous, previousVelocity);
+            x[i] = r[0];
+            y[i] = r[1];
+            z[i] = r[2];
+            prevX[i] = previous[0];
+            prevY[i] = previous[1];
+            prevZ[i] = previous[2];
+            vx[i] = v[0];
+            vy[i] = v[1];
+            vz[i] = v[2];
+            updateGeodetic(i);
+        }
+    });
+}
+
+size_t BodyStore::getConicCount() const
+{
+    return std::count(onConic.begin(), onConic.end(), 1);
+}
+
+void BodyStore::accumulateForces(size_t begin, size_t end, double deltaTime)
+{
+    // bodies with batched force terms, evaluated together once the loop is done
+    thread_local std::vector<uint32_t> batch;
+    batch.clear();
+
+    for (size_t i = begin; i < end; i++)
+    {
+        // a conic due to reach the atmosphere within the step goes back to stepping from its state now
+        if (onConic[i])
+        {
+            if (time + deltaTime < orbit[i].wake)
+                continue;
+            leaveConic(i);
+        }
+        // bodies on the ground stay put
+        if (alt[i] <= 0)
+        {
+            fx[i] = fy[i] = fz[i] = 0.0;
+            vx[i] = vy[i] = vz[i] = 0.0;
+            forceCurrent[i] = 0;
+            continue;
+        }
+        if (!Integrators::needsStartForce(integrator[i]))
+            continue;
+        if (forceCurrent[i])
+        {
+            forceCurrent[i] = 0;
+            continue;
+        }
+
+        fx[i] = fy[i] = fz[i] = 0.0;
+        if (!hasForces(forceModel[i]))
+            continue;
+
+        Position position(x[i], y[i], z[i], vx[i], vy[i], vz[i], lat[i], lon[i], alt[i]);
+        applyUnbatchedForces(forceModel[i], position, mass[i], deltaTime);
+        position.getTotalForce(fx[i], fy[i], fz[i]);
+        if (hasBatchedForces(forceModel[i]))
+            batch.push_back(i);
+    }
+    applyBatchedForces(batch);
+}
+
+void BodyStore::applyBatchedForces(const std::vector<uint32_t> &batch)
+{
+    if (batch.empty())
+        return;
+
+    // HarmonicGravityForce is the only batched term, gather the slice's positions for one field pass
+    thread_local std::vector<double> gathered[6];
+    for (auto &column : gathered)
+        column.resize(batch.size());
+    for (size_t k = 0; k < batch.size(); k++)
+    {
+        gathered[0][k] = x[batch[k]];
+        gathered[1][k] = y[batch[k]];
+        gathered[2][k] = z[batch[k]];
+    }
+    GravityField::getInstance()->acceleration(gathered[0].data(), gathered[1].data(), gathered[2].data(),
+                                              gathered[3].data(), gathered[4].data(), gathered[5].data(), batch.size());
+    for (size_t k = 0; k < batch.size(); k++)
+    {
+        uint32_t i = batch[k];
+        fx[i] += gathered[3][k] * mass[i];
+        fy[i] += gathered[4][k] * mass[i];
+        fz[i] += gathered[5][k] * mass[i];
+    }
+}
+
+void BodyStore::integrate(size_t begin, size_t end, double deltaTime)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        if (onConic[i])
+            continue;
+        prevX[i] = x[i];
+        prevY[i] = y[i];
+        prevZ[i] = z[i];
+        prevVx[i] = vx[i];
+        prevVy[i] = vy[i];
+        prevVz[i] = vz[i];
+        prevAlt[i] = alt[i];
+
+        if (alt[i] <= 0)
+            continue;
+
+        switch (integrator[i])
+        {
+        case Integrator::SemiImplicitEuler:
+        {
+            // same scheme as Position::applyForce, kept inline as the common case
+            double invMass = 1.0 / mass[i];
+            vx[i] += fx[i] * invMass * deltaTime;
+            vy[i] += fy[i] * invMass * deltaTime;
+            vz[i] += fz[i] * invMass * deltaTime;
+
+            x[i] += vx[i] * deltaTime;
+            y[i] += vy[i] * deltaTime;
+            z[i] += vz[i] * deltaTime;
+            break;
+        }
+        case Integrator::VelocityVerlet:
+            Integrators::velocityVerlet(*this, i, deltaTime);
+            break;
+        case Integrator::Leapfrog:
+            Integrators::leapfrog(*this, i, deltaTime);
+            break;
+        case Integrator::RK4:
+            Integrators::rk4(*this, i, deltaTime);
+            break;
+        case Integrator::DormandPrince:
+            Integrators::dormandPrince(*this, i, deltaTime);
+            break;
+        }
+    }
+}
+
+void BodyStore::acceleration(size_t i, const double pos[3], const double vel[3], double acc[3], double deltaTime) const
+{
+    // columns order of the geodetic cache, see updateGeodetic
+    double geo[3];
+    WGS84::toGeodetic(&pos[0], &pos[1], &pos[2], &geo[0], &geo[1], &geo[2], 1);
+
+    Position position(pos[0], pos[1], pos[2], vel[0], vel[1], vel[2], geo[0], geo[1], geo[2]);
+    applyForces(forceModel[i], position, mass[i], deltaTime);
+
+    double force[3];
+    position.getTotalForce(force[0], force[1], force[2]);
+    for (int k = 0; k < 3; k++)
+        acc[k] = force[k] / mass[i];
+}
+
+void BodyStore::updateGeodetic(size_t begin, size_t end)
+{
+    // one batch conversion over the whole slice, resting bodies are recomputed to the same values
+    // columns are passed in the order of the scalar toGeodetic result (see Position::updateGeodetic)
+    WGS84::toGeodetic(&x[begin], &y[begin], &z[begin], &lat[begin], &lon[begin], &alt[begin], end - begin);
+}
+
+void BodyStore::updateSteppedGeodetic(size_t begin, size_t end)
+{
+    PerfCounters::Scope perf(PerfCounters::Geodesy, end - begin);
+    // one batch per run of stepped bodies
+    size_t run = begin;
+    for (size_t i = begin; i < end; i++)
+        if (onConic[i])
+        {
+            if (run < i)
+                updateGeodetic(run, i);
+            run = i + 1;
+        }
+    if (run < end)
+        updateGeodetic(run, end);
+}
+
+void BodyStore::updateGeodetic(size_t index)
+{
+    updateGeodetic(index, index + 1);
+}
+
+glm::vec3 BodyStore::getECEF(BodyHandle handle) const
+{
+    size_t i = indexOf(handle);
+    return glm::vec3(x[i], y[i], z[i]);
+}
+
+glm::vec3 BodyStore::getInterpolatedECEF(BodyHandle handle, float alpha) const
+{
+    size_t i = indexOf(handle);
+    return glm::vec3(prevX[i] + (x[i] - prevX[i]) * alpha,
+                     prevY[i] + (y[i] - prevY[i]) * alpha,
+                     prevZ[i] + (z[i] - prevZ[i]) * alpha);
+}
+
+glm::vec3 BodyStore::getVelocity(BodyHandle handle) const
+{
+    size_t i = indexOf(handle);
+    return glm::vec3(vx[i], vy[i], vz[i]);
+}
+
+void BodyStore::setECEF(BodyHandle handle, const glm::vec3 &ecef)
+{
+    wake(handle);
+    size_t i = indexOf(handle);
+    // keeps the velocity the conic has now
+    if (onConic[i])
+        leaveConic(i);
+    x[i] = prevX[i] = ecef.x;
+    y[i] = prevY[i] = ecef.y;
+    z[i] = prevZ[i] = ecef.z;
+    forceCurrent[i] = 0;
+    stepSize[i] = 0.0;
+    updateGeodetic(i);
+}
+
+void BodyStore::setVelocity(BodyHandle handle, const glm::vec3 &velocity)
+{
+    wake(handle);
+    size_t i = indexOf(handle);
+    // the position has to catch up with the conic before the new velocity applies
+    if (onConic[i])
+        leaveConic(i);
+    vx[i] = velocity.x;
+    vy[i] = velocity.y;
+    vz[i] = velocity.z;
+    forceCurrent[i] = 0;
+    stepSize[i] = 0.0;
+}
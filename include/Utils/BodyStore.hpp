@@ -0,0 +1,236 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Utils/Physics.hpp"
+#include "Utils/ForceModels.hpp"
+#include "Utils/Integrators.hpp"
+#include "Utils/Kepler.hpp"
+
+struct BodyEvent;
+
+// Stable reference to a body in the BodyStore, survives the store compacting its arrays
+struct BodyHandle {
+    static constexpr uint32_t Invalid = UINT32_MAX;
+    uint32_t id = Invalid;
+
+    bool valid() const { return id != Invalid; }
+};
+
+/*
+    contiguous structure-of-arrays storage for every simulated body
+
+    each column holds one value for all bodies, so the batch step walks
+    plain double arrays instead of chasing one Object pointer per body.
+    bodies are addressed from the outside by BodyHandle, the store keeps
+    an id -> index table so removal can swap the last body into the hole
+*/
+class BodyStore {
+public:
+        BodyStore(const BodyStore &obj) = delete;
+        static BodyStore *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new BodyStore();
+            return instance;
+        }
+
+    BodyHandle create(const glm::vec3 &ecef, const glm::vec3 &velocity, double mass);
+    void destroy(BodyHandle handle);
+    void clear();
+    void reserve(size_t count);
+
+    size_t size() const { return x.size(); }
+    // bytes the per-body columns and the handle tables hold, capacity included
+    size_t memoryUsage() const;
+    size_t indexOf(BodyHandle handle) const { return slotOf[handle.id]; }
+    BodyHandle handleOf(size_t index) const { return BodyHandle{idOf[index]}; }
+    // upper bound of the handle ids given out so far, for tables indexed by id
+    size_t handleCount() const { return slotOf.size(); }
+    // false once the body was destroyed (until its id is given out again)
+    bool contains(BodyHandle handle) const
+    {
+        return handle.id < slotOf.size() && slotOf[handle.id] < idOf.size() && idOf[slotOf[handle.id]] == handle.id;
+    }
+
+    // replaces the body's force stack, bodies start with ForceModels::None
+    void setForceModel(BodyHandle handle, const ForceModel &model);
+
+    void setIntegrator(BodyHandle handle, Integrator scheme);
+    Integrator getDefaultIntegrator() const { return defaultIntegrator; }
+    // scheme for bodies created from now on, applyToAll switches the existing ones too
+    void setDefaultIntegrator(Integrator scheme, bool applyToAll);
+
+    // local error tolerance of the adaptive integrator, absolute and relative to the state
+    double getTolerance() const { return tolerance; }
+    void setTolerance(double value) { tolerance = value; }
+
+    /*
+        bodies whose force model follows a conic (ForceSet::conic) switch to analytic Kepler
+        motion once their geocentric radius is past A + altitude, and back to numerical
+        stepping when the conic brings them down to it again. the conic keeps the central
+        WGS84::GM term only, so higher harmonics and any drag above that altitude are dropped.
+        a body on a conic costs nothing per step, syncConics() brings its state up to date.
+        altitude in meters, 0 or less turns the handoff off
+    */
+    double getKeplerAltitude() const { return keplerAltitude; }
+    void setKeplerAltitude(double meters);
+    // evaluates every conic at the current time, call once per frame before reading the positions
+    void syncConics();
+    size_t getConicCount() const;
+    // simulated seconds advanced by step so far
+    double getTime() const { return time; }
+
+    /*
+        bodies that cannot move any more (on the ground, or without forces and at rest)
+        fall asleep at the end of a step and are kept after the awake ones, so step()
+        only walks [0, getActiveCount()). setECEF, setVelocity, setForceModel, a
+        collision or wake() put them back. falling asleep and waking reorder the
+        indices, handles stay valid
+    */
+    bool isSleepEnabled() const { return sleepEnabled; }
+    // turning it off wakes everything
+    void setSleepEnabled(bool enabled);
+    size_t getActiveCount() const { return activeCount; }
+    bool isSleeping(BodyHandle handle) const { return indexOf(handle) >= activeCount; }
+    // sim time the body last fell asleep, a new value means it may have moved in between
+    double getSleptAt(BodyHandle handle) const { return sleptAt[indexOf(handle)]; }
+    void wake(BodyHandle handle);
+    void wakeAll();
+    // changes whenever the sleeping bodies, their order or their radius change
+    uint64_t getSleepVersion() const { return sleepVersion; }
+
+    /*
+        impacts and altitude crossings are located inside the step, on the cubic Hermite
+        through the body's positions and velocities at both ends of it, so where a body
+        lands does not depend on the step size. an impact stops the body on the ellipsoid,
+        every crossing is pushed to the EventQueue. conics are not watched, their state is
+        only known at syncConics
+    */
+    // thresholds in meters above the ellipsoid, crossings both ways are reported
+    void addAltitudeEvent(double meters);
+    void removeAltitudeEvent(double meters);
+    void clearAltitudeEvents() { altitudeEvents.clear(); }
+    const std::vector<double> &getAltitudeEvents() const { return altitudeEvents; }
+
+    // acceleration body i would have at the given state, for integrators that sample inside a step
+    void acceleration(size_t i, const double pos[3], const double vel[3], double acc[3], double deltaTime) const;
+
+    // advances every body by deltaTime : accumulate forces, integrate, refresh geodetic
+    // bodies are independent during a step, so slices of them run in parallel on the JobSystem
+    void step(double deltaTime);
+
+    // the phases of step, split by body range so they can be run on slices
+    void accumulateForces(size_t begin, size_t end, double deltaTime);
+    void integrate(size_t begin, size_t end, double deltaTime);
+    void updateGeodetic(size_t begin, size_t end);
+
+    glm::vec3 getECEF(BodyHandle handle) const;
+    // position between the previous and the current step, alpha in [0,1]
+    glm::vec3 getInterpolatedECEF(BodyHandle handle, float alpha) const;
+    glm::vec3 getVelocity(BodyHandle handle) const;
+    double getAltitude(BodyHandle handle) const { return alt[indexOf(handle)]; }
+    double getMass(BodyHandle handle) const { return mass[indexOf(handle)]; }
+
+    void setECEF(BodyHandle handle, const glm::vec3 &ecef);
+    void setVelocity(BodyHandle handle, const glm::vec3 &velocity);
+    void setMass(BodyHandle handle, double newMass) { mass[indexOf(handle)] = newMass; }
+    double getRadius(BodyHandle handle) const { return radius[indexOf(handle)]; }
+    void setRadius(BodyHandle handle, double newRadius)
+    {
+        radius[indexOf(handle)] = newRadius;
+        sleepVersion++;
+    }
+
+    // ECEF position
+    std::vector<double> x, y, z;
+    // ECEF position before the last step, used to interpolate rendering
+    std::vector<double> prevX, prevY, prevZ;
+    // velocity
+    std::vector<double> vx, vy, vz;
+    // velocity and altitude before the last step, the other end of the event search
+    std::vector<double> prevVx, prevVy, prevVz, prevAlt;
+    // accumulated force for the current step
+    std::vector<double> fx, fy, fz;
+    std::vector<double> mass;
+    // bounding sphere used by Collisions
+    std::vector<double> radius;
+    // geodetic cache, same layout Position keeps (see Position::updateGeodetic)
+    std::vector<double> lat, lon, alt;
+    std::vector<ForceModel> forceModel;
+    std::vector<Integrator> integrator;
+    // fx/fy/fz already hold the force at the current state (left there by VelocityVerlet)
+    std::vector<uint8_t> forceCurrent;
+    // DormandPrince sub step size for the next step (0 = not started yet) and the last accepted error / tolerance
+    std::vector<double> stepSize, stepError;
+    // the body coasts on orbit instead of being stepped, x/y/z and v are only current after syncConics
+    std::vector<uint8_t> onConic;
+    std::vector<Kepler::Orbit> orbit;
+    // sim time the body last fell asleep
+    std::vector<double> sleptAt;
+
+private:
+    static BodyStore *instance;
+    BodyStore() = default;
+
+    // bodies per parallel job, below this the job overhead beats the work
+    static constexpr size_t stepGrain = 512;
+    // bounding sphere of the unit cube Rock and Cube are drawn with
+    static constexpr double defaultRadius = 0.8660254037844386;
+
+    std::vector<uint32_t> slotOf; // handle id -> array index
+    std::vector<uint32_t> idOf;   // array index -> handle id
+    std::vector<uint32_t> freeIds;
+    Integrator defaultIntegrator = Integrator::SemiImplicitEuler;
+    double tolerance = 1e-6;
+    double time = 0.0;
+    double lastStep = 0.0;
+    // top of the US1976 extension, no drag is lost by default
+    double keplerAltitude = 1000e3;
+    bool sleepEnabled = true;
+    size_t activeCount = 0;
+    uint64_t sleepVersion = 0;
+    // meters, sorted
+    std::vector<double> altitudeEvents;
+
+    // calls fn on every per-body column, so create/destroy/clear touch them all
+    template <class Fn>
+    void forEachColumn(Fn fn) { columnsOf(*this, fn); }
+    template <class Fn>
+    void forEachColumn(Fn fn) const { columnsOf(*this, fn); }
+    template <class Store, class Fn>
+    static void columnsOf(Store &store, Fn fn)
+    {
+        for (auto column : {&store.x, &store.y, &store.z, &store.prevX, &store.prevY, &store.prevZ, &store.vx, &store.vy, &store.vz,
+                            &store.prevVx, &store.prevVy, &store.prevVz, &store.prevAlt, &store.fx, &store.fy, &store.fz,
+                            &store.mass, &store.radius, &store.lat, &store.lon, &store.alt, &store.stepSize, &store.stepError, &store.sleptAt})
+            fn(*column);
+        fn(store.forceModel);
+        fn(store.integrator);
+        fn(store.forceCurrent);
+        fn(store.onConic);
+        fn(store.orbit);
+        fn(store.idOf);
+    }
+
+    void updateGeodetic(size_t index);
+    // updateGeodetic over the slice's bodies that are stepped, conics keep theirs until syncConics
+    void updateSteppedGeodetic(size_t begin, size_t end);
+    // finds where the slice's bodies crossed the ground or a threshold during the step just integrated
+    void locateEvents(size_t begin, size_t end, double deltaTime, std::vector<BodyEvent> &found);
+    // hands the slice's eligible bodies to a conic starting at epoch
+    void enterConics(size_t begin, size_t end, double epoch);
+    // puts body i back on numerical stepping at the current time
+    void leaveConic(size_t i);
+    // exchanges two bodies' slots in every column
+    void swapBodies(size_t a, size_t b);
+    // true when body i can not move until something wakes it
+    bool isResting(size_t i) const;
+    // puts the awake bodies that came to rest during the step to sleep
+    void settle();
+    // adds the batched force terms (see ForceSet) of the listed bodies to fx/fy/fz
+    void applyBatchedForces(const std::vector<uint32_t> &batch);
+};
@@ -0,0 +1,275 @@
+#include "Utils/Collisions.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/Trace.hpp"
+#include <algorithm>
+#include <cmath>
+
+Collisions *Collisions::instance = nullptr;
+
+void Collisions::step(BodyStore &bodies)
+{
+    if (!enabled)
+    {
+        contacts.clear();
+        return;
+    }
+    detect(bodies);
+    resolve(bodies);
+}
+
+uint64_t Collisions::cellKey(int64_t cx, int64_t cy, int64_t cz)
+{
+    // 21 bits per axis, blocks further apart than that alias to the same buckets, the cell check sorts them out
+    const uint64_t bits = (1ull << 21) - 1;
+    return (static_cast<uint64_t>(cx) & bits) | (static_cast<uint64_t>(cy) & bits) << 21 |
+           (static_cast<uint64_t>(cz) & bits) << 42;
+}
+
+uint32_t Collisions::Grid::bucketOf(int64_t cx, int64_t cy, int64_t cz) const
+{
+    // 4x4x4 blocks of cells hash to 64 consecutive buckets, so the neighbours of a cell share cache lines
+    uint64_t block = cellKey(cx >> 2, cy >> 2, cz >> 2) * 0x9E3779B97F4A7C15ull;
+    uint32_t local = static_cast<uint32_t>((cx & 3) | (cy & 3) << 2 | (cz & 3) << 4);
+    return (static_cast<uint32_t>(block >> 32) << 6 | local) & bucketMask;
+}
+
+size_t Collisions::Grid::memoryUsage() const
+{
+    size_t bytes = fillCapacity * sizeof(std::atomic<uint32_t>);
+    for (auto column : {&cellX, &cellY, &cellZ, &sortedCellX, &sortedCellY, &sortedCellZ})
+        bytes += column->capacity() * sizeof(int32_t);
+    for (auto column : {&bucket, &start, &sorted})
+        bytes += column->capacity() * sizeof(uint32_t);
+    for (auto column : {&sortedX, &sortedY, &sortedZ, &sortedRadius})
+        bytes += column->capacity() * sizeof(double);
+    return bytes + sortedCoasting.capacity();
+}
+
+size_t Collisions::memoryUsage() const
+{
+    size_t bytes = awake.memoryUsage() + asleep.memoryUsage();
+    for (const auto &chunk : chunkContacts)
+        bytes += chunk.capacity() * sizeof(Contact);
+    return bytes + contacts.capacity() * sizeof(Contact) + woken.capacity() * sizeof(BodyHandle);
+}
+
+void Collisions::Grid::build(const BodyStore &bodies, size_t from, size_t to, double cellSize)
+{
+    first = from;
+    count = to - from;
+    if (count == 0)
+    {
+        // a single empty bucket every lookup lands in
+        bucketMask = 0;
+        start.assign(2, 0);
+        return;
+    }
+    Utils::JobSystem *jobs = Utils::JobSystem::getInstance();
+    double invCell = 1.0 / cellSize;
+
+    size_t buckets = 64;
+    while (buckets < count)
+        buckets <<= 1;
+    bucketMask = static_cast<uint32_t>(buckets - 1);
+    if (fillCapacity < buckets)
+    {
+        fill.reset(new std::atomic<uint32_t>[buckets]);
+        fillCapacity = buckets;
+    }
+    for (size_t k = 0; k < buckets; k++)
+        fill[k].store(0, std::memory_order_relaxed);
+
+    for (auto column : {&bucket, &sorted})
+        column->resize(count);
+    for (auto column : {&cellX, &cellY, &cellZ})
+        column->resize(count);
+    for (auto column : {&sortedX, &sortedY, &sortedZ, &sortedRadius})
+        column->resize(count);
+    for (auto column : {&sortedCellX, &sortedCellY, &sortedCellZ})
+        column->resize(count);
+    sortedCoasting.resize(count);
+    start.resize(buckets + 1);
+
+    jobs->parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            size_t i = first + k;
+            cellX[k] = static_cast<int32_t>(std::floor(bodies.x[i] * invCell));
+            cellY[k] = static_cast<int32_t>(std::floor(bodies.y[i] * invCell));
+            cellZ[k] = static_cast<int32_t>(std::floor(bodies.z[i] * invCell));
+            bucket[k] = bucketOf(cellX[k], cellY[k], cellZ[k]);
+            fill[bucket[k]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // exclusive prefix sum, fill becomes the write cursor of each bucket
+    uint32_t total = 0;
+    for (size_t k = 0; k < buckets; k++)
+    {
+        start[k] = total;
+        total += fill[k].load(std::memory_order_relaxed);
+        fill[k].store(start[k], std::memory_order_relaxed);
+    }
+    start[buckets] = total;
+
+    jobs->parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+            sorted[fill[bucket[k]].fetch_add(1, std::memory_order_relaxed)] = first + k;
+    });
+
+    // scatter order depends on the threads, buckets hold about one body so sorting them is cheap
+    jobs->parallelFor(buckets, grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            std::sort(sorted.begin() + start[k], sorted.begin() + start[k + 1]);
+            for (uint32_t s = start[k]; s < start[k + 1]; s++)
+            {
+                uint32_t i = sorted[s];
+                sortedX[s] = bodies.x[i];
+                sortedY[s] = bodies.y[i];
+                sortedZ[s] = bodies.z[i];
+                sortedRadius[s] = bodies.radius[i];
+                sortedCellX[s] = cellX[i - first];
+                sortedCellY[s] = cellY[i - first];
+                sortedCellZ[s] = cellZ[i - first];
+                sortedCoasting[s] = bodies.onConic[i];
+            }
+        }
+    });
+}
+
+void Collisions::findContacts(size_t begin, size_t end, const Grid &grid, std::vector<Contact> &out) const
+{
+    for (size_t s = begin; s < end; s++)
+    {
+        if (awake.sortedCoasting[s])
+            continue;
+        uint32_t i = awake.sorted[s];
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dz = -1; dz <= 1; dz++)
+                {
+                    int32_t cx = awake.sortedCellX[s] + dx, cy = awake.sortedCellY[s] + dy, cz = awake.sortedCellZ[s] + dz;
+                    uint32_t k = grid.bucketOf(cx, cy, cz);
+                    for (uint32_t t = grid.start[k]; t < grid.start[k + 1]; t++)
+                    {
+                        uint32_t j = grid.sorted[t];
+                        if (j <= i || grid.sortedCellX[t] != cx || grid.sortedCellY[t] != cy || grid.sortedCellZ[t] != cz ||
+                            grid.sortedCoasting[t])
+                            continue;
+                        double ddx = grid.sortedX[t] - awake.sortedX[s];
+                        double ddy = grid.sortedY[t] - awake.sortedY[s];
+                        double ddz = grid.sortedZ[t] - awake.sortedZ[s];
+                        double reach = awake.sortedRadius[s] + grid.sortedRadius[t];
+                        double distance2 = ddx * ddx + ddy * ddy + ddz * ddz;
+                        if (distance2 >= reach * reach)
+                            continue;
+
+                        // coincident centers get an arbitrary normal
+                        Contact contact{i, j, 0.0, 0.0, 1.0, reach};
+                        double distance = std::sqrt(distance2);
+                        if (distance > 0.0)
+                        {
+                            contact.nx = ddx / distance;
+                            contact.ny = ddy / distance;
+                            contact.nz = ddz / distance;
+                            contact.depth = reach - distance;
+                        }
+                        out.push_back(contact);
+                    }
+                }
+    }
+}
+
+void Collisions::detect(const BodyStore &bodies)
+{
+    TRACE_SCOPE("collision detect");
+    contacts.clear();
+    size_t count = bodies.size();
+    size_t active = bodies.getActiveCount();
+    if (count < 2 || active == 0)
+        return;
+
+    // a cell twice the largest radius keeps every overlap within the neighbouring cells
+    if (bodies.getSleepVersion() != asleepVersion)
+        asleepRadius = active < count ? *std::max_element(bodies.radius.begin() + active, bodies.radius.end()) : 0.0;
+    double maxRadius = std::max(asleepRadius, *std::max_element(bodies.radius.begin(), bodies.radius.begin() + active));
+    cellSize = std::max(2.0 * maxRadius, 1e-6);
+
+    awake.build(bodies, 0, active, cellSize);
+    if (bodies.getSleepVersion() != asleepVersion || cellSize != asleepCellSize)
+    {
+        asleep.build(bodies, active, count, cellSize);
+        asleepVersion = bodies.getSleepVersion();
+        asleepCellSize = cellSize;
+    }
+
+    // fixed chunks of the sorted order so the contacts concatenate the same way whatever thread ran them
+    size_t chunks = (active + grain - 1) / grain;
+    chunkContacts.resize(chunks);
+    Utils::JobSystem::getInstance()->parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        TRACE_SCOPE("find contacts");
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            chunkContacts[chunk].clear();
+            size_t from = chunk * grain, to = std::min(active, (chunk + 1) * grain);
+            findContacts(from, to, awake, chunkContacts[chunk]);
+            findContacts(from, to, asleep, chunkContacts[chunk]);
+        }
+    });
+    for (const auto &found : chunkContacts)
+        contacts.insert(contacts.end(), found.begin(), found.end());
+}
+
+void Collisions::resolve(BodyStore &bodies)
+{
+    TRACE_SCOPE("collision resolve");
+    // share of the overlap removed per step and the overlap left alone, so resting contacts do not jitter
+    const double correction = 0.8;
+    const double slop = 0.01;
+
+    // waking reorders the store, so the sleepers are woken after the loop
+    woken.clear();
+    for (const Contact &contact : contacts)
+    {
+        uint32_t a = contact.a, b = contact.b;
+        double wa = bodies.alt[a] > 0 ? 1.0 / bodies.mass[a] : 0.0;
+        double wb = bodies.alt[b] > 0 ? 1.0 / bodies.mass[b] : 0.0;
+        double w = wa + wb;
+        if (w == 0.0)
+            continue;
+        // only b can be asleep, contacts start from awake bodies
+        if (wb > 0.0 && b >= bodies.getActiveCount())
+            woken.push_back(bodies.handleOf(b));
+
+        // impulse only while the bodies approach each other
+        double vn = (bodies.vx[b] - bodies.vx[a]) * contact.nx + (bodies.vy[b] - bodies.vy[a]) * contact.ny +
+                    (bodies.vz[b] - bodies.vz[a]) * contact.nz;
+        if (vn < 0.0)
+        {
+            double impulse = -(1.0 + restitution) * vn / w;
+            bodies.vx[a] -= impulse * wa * contact.nx;
+            bodies.vy[a] -= impulse * wa * contact.ny;
+            bodies.vz[a] -= impulse * wa * contact.nz;
+            bodies.vx[b] += impulse * wb * contact.nx;
+            bodies.vy[b] += impulse * wb * contact.ny;
+            bodies.vz[b] += impulse * wb * contact.nz;
+        }
+
+        // the state changed under the integrators' cached start force, and the geodetic cache once moved
+        double push = std::max(contact.depth - slop, 0.0) * correction / w;
+        bodies.forceCurrent[a] = bodies.forceCurrent[b] = 0;
+        if (push == 0.0)
+            continue;
+        bodies.x[a] -= push * wa * contact.nx;
+        bodies.y[a] -= push * wa * contact.ny;
+        bodies.z[a] -= push * wa * contact.nz;
+        bodies.x[b] += push * wb * contact.nx;
+        bodies.y[b] += push * wb * contact.ny;
+        bodies.z[b] += push * wb * contact.nz;
+        bodies.updateGeodetic(a, a + 1);
+        bodies.updateGeodetic(b, b + 1);
+    }
+    for (BodyHandle handle : woken)
+        bodies.wake(handle);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Utils/BodyStore.hpp"
+
+// two overlapping bodies found by the narrowphase
+struct Contact {
+    uint32_t a, b;      // BodyStore indices at detection time, a < b
+    double nx, ny, nz;  // unit normal pointing from a to b
+    double depth;       // overlap of the bounding spheres along the normal
+};
+
+/*
+    body vs body collisions on the BodyStore bounding spheres
+
+    broadphase is a uniform spatial hash over ECEF rebuilt every step : cells
+    are twice the largest radius so a body only meets the 27 cells around
+    its own, 4x4x4 blocks of cells are hashed to runs of 64 buckets of a
+    power of two table sized to the body count (neighbouring cells stay in
+    the same cache lines), and the table is filled with a parallel
+    counting sort (atomic counts, prefix sum, atomic scatter, then each
+    bucket ordered by body index so results do not depend on the threads).
+    positions are copied in bucket order so the neighbour scans read
+    contiguous memory. every pass is O(n), far apart bodies are never paired.
+
+    the narrowphase walks the buckets in parallel, a candidate counts only if
+    its cell is the cell being looked at (buckets are shared by hash
+    collisions) and only pairs with a < b are kept, so each contact is
+    reported once. resolve() then applies restitution impulses and pushes
+    the spheres apart, bodies on the ground act as static. bodies coasting
+    on a Kepler conic are left out, their positions lag until syncConics.
+
+    sleeping bodies (see BodyStore) do not move, so they get a second grid
+    that is only rebuilt when the store's sleep version or the cell size
+    changes. the awake bodies are hashed every step and look for contacts
+    in both grids, sleepers never meet each other. a sleeper an awake body
+    pushes is woken once the contacts are resolved
+*/
+class Collisions {
+public:
+        Collisions(const Collisions &obj) = delete;
+        static Collisions *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new Collisions();
+            return instance;
+        }
+
+    // detect then resolve, called after every BodyStore step
+    void step(BodyStore &bodies);
+    void detect(const BodyStore &bodies);
+    void resolve(BodyStore &bodies);
+
+    const std::vector<Contact> &getContacts() const { return contacts; }
+    double getCellSize() const { return cellSize; }
+    // bytes held by the grids and contact lists, capacity included
+    size_t memoryUsage() const;
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool value) { enabled = value; }
+    double getRestitution() const { return restitution; }
+    void setRestitution(double value) { restitution = value; }
+
+private:
+    static Collisions *instance;
+    Collisions() = default;
+
+    // bodies per parallel job
+    static constexpr size_t grain = 1024;
+
+    // spatial hash of the bodies [first, first + count) of the store
+    struct Grid {
+        size_t first = 0, count = 0;
+        uint32_t bucketMask = 0;
+        // per body cell coordinates and bucket, only meaningful while building
+        std::vector<int32_t> cellX, cellY, cellZ;
+        std::vector<uint32_t> bucket;
+        std::unique_ptr<std::atomic<uint32_t>[]> fill;
+        size_t fillCapacity = 0;
+        // bodies of bucket k are sorted[start[k] .. start[k + 1]), as store indices
+        std::vector<uint32_t> start;
+        std::vector<uint32_t> sorted;
+        // body data copied in sorted order for the scans
+        std::vector<double> sortedX, sortedY, sortedZ, sortedRadius;
+        std::vector<int32_t> sortedCellX, sortedCellY, sortedCellZ;
+        std::vector<uint8_t> sortedCoasting;
+
+        void build(const BodyStore &bodies, size_t from, size_t to, double cellSize);
+        uint32_t bucketOf(int64_t cx, int64_t cy, int64_t cz) const;
+        size_t memoryUsage() const;
+    };
+
+    static uint64_t cellKey(int64_t cx, int64_t cy, int64_t cz);
+    // contacts of the awake grid's sorted bodies [begin, end) with larger indices in grid
+    void findContacts(size_t begin, size_t end, const Grid &grid, std::vector<Contact> &out) const;
+
+    bool enabled = true;
+    double restitution = 0.5;
+    double cellSize = 1.0;
+
+    Grid awake;
+    Grid asleep;
+    // largest sleeper radius, and the sleep version and cell size the asleep grid was built for
+    double asleepRadius = 0.0;
+    uint64_t asleepVersion = UINT64_MAX;
+    double asleepCellSize = 0.0;
+
+    std::vector<std::vector<Contact>> chunkContacts;
+    std::vector<Contact> contacts;
+    std::vector<BodyHandle> woken;
+};
@@ -137,8 +137,15 @@ void Console::render() {
 
         renderText(currentObjectCount(), windowWidth-12*lineSize*scale, windowHeight-4*lineSize * scale, scale);
 
+        renderText(currentBodyCount(), windowWidth-12*lineSize*scale, windowHeight-5*lineSize * scale, scale);
+
         renderText(currentTimeSpeed(), windowWidth-12*lineSize*scale, windowHeight-6*lineSize * scale, scale);
 
+        renderText(currentSimSteps(), windowWidth-12*lineSize*scale, windowHeight-7*lineSize * scale, scale);
+
+        for (size_t k = 0; k < profileLines.size(); k++)
+            renderText(profileLines[k], windowWidth-12*lineSize*scale, windowHeight-(9+k)*lineSize * scale, scale);
+
         renderText(currentTime(), windowWidth-24*lineSize*scale, lineSize * scale, scale);
 
 
@@ -301,34 +308,10 @@ float Console::renderCharacter(char c,float x,float y,float scale,float shiftLef
         auto it = commands.find(cmd);
         if (it != commands.end()) {
             std::string argsStr = command.substr(command.find(cmd) + cmd.length());
-            argsStr = trim(argsStr);
-            std::vector<std::string> args = splitArgs(argsStr);
+            argsStr = ConsoleArgs::trim(argsStr);
+            std::vector<std::string> args = ConsoleArgs::split(argsStr);
             return it->second(args);
         } else {
             return "Unknown command: " + cmd;
         }
     }
-
-std::string Console::trim(const std::string &str) {
-    size_t first = str.find_first_not_of(' ');
-    if (first == std::string::npos) return "";
-    size_t last = str.find_last_not_of(' ');
-    return str.substr(first, last - first + 1);
-}
-
-std::vector<std::string> Console::splitArgs(const std::string &args) {
-    std::vector<std::string> result;
-    std::regex re(R"((\"[^\"]*\")|(\S+))");
-    std::sregex_iterator it(args.begin(), args.end(), re);
-    std::sregex_iterator end;
-    while (it != end) {
-        std::smatch match = *it;
-        if (match[1].matched) {
-            result.push_back(match[1].str().substr(1, match[1].str().length() - 2)); // Remove quotes
-        } else {
-            result.push_back(match[2].str());
-        }
-        ++it;
-    }
-    return result;
-}
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include "Utils/Shader.hpp"
 #include "Utils/Window.hpp"
 #include "Utils/Timer.hpp"
+#include "Utils/ConsoleArgs.hpp"
 #define COMMAND_FUNC std::function<std::string(const std::vector<std::string> &)>
 
 
@@ -48,9 +49,11 @@ public:
 
     void addCommand(std::string name,COMMAND_FUNC handle){commands[name] = handle;}
     void updateObjectCount(int count){objectsCount=count;}
+    void updateBodyCount(size_t active, size_t sleeping){activeBodies=active;sleepingBodies=sleeping;}
     void updateCameraYaw(float yaw){cameraYaw=yaw;}
     void updateCameraPitch(float pitch){cameraPitch=pitch;}
     void updateCameraPos(glm::vec3 pos){cameraPosition=pos;}
+    void updateProfile(const std::vector<std::string> &profile){profileLines=profile;}
 
     bool isOpen=false;
     bool debugInfo=false;
@@ -68,9 +71,12 @@ private:
 
 
     int objectsCount=0;
+    size_t activeBodies=0;
+    size_t sleepingBodies=0;
     float cameraYaw=0;
     float cameraPitch=0;
     glm::vec3 cameraPosition=glm::vec3(0.f);
+    std::vector<std::string> profileLines;
     // unorderd map brakes engine
     std::map<std::string, COMMAND_FUNC> commands;
     
@@ -92,8 +98,6 @@ private:
     void addMessage(const std::string &message);
     void addInput(int c,bool shift);
     std::string processCommand(const std::string &command);
-    std::string trim(const std::string &str);
-    std::vector<std::string> splitArgs(const std::string &args);
     void renderText(const std::string &text, float x, float y, float scale);
     float renderCharacter(char c, float x, float y, float scale);
     float renderCharacter(char c, float x, float y, float scale,float shiftLeft);
@@ -128,6 +132,15 @@ private:
         return oss.str();
     }
 
+    std::string currentBodyCount()
+    {
+        std::ostringstream oss;
+
+        oss << "active:" << activeBodies << "|sleeping:" << sleepingBodies;
+
+        return oss.str();
+    }
+
 std::string currentTime()
         {
             std::ostringstream oss;
@@ -161,6 +174,13 @@ std::string currentTimeSpeed()
             return oss.str();
 }
 
+std::string currentSimSteps()
+{
+            std::ostringstream oss;
+            oss << "phys: " << timer->getSimStepsLastFrame() << "x" << timer->getSimStep() << "s";
+            return oss.str();
+}
+
     int ShiftChar(int c) {
     switch (c) {
         case '`': return '~';
@@ -0,0 +1,26 @@
+#include "Utils/ConsoleArgs.hpp"
+#include <regex>
+
+std::string ConsoleArgs::trim(const std::string &str) {
+    size_t first = str.find_first_not_of(' ');
+    if (first == std::string::npos) return "";
+    size_t last = str.find_last_not_of(' ');
+    return str.substr(first, last - first + 1);
+}
+
+std::vector<std::string> ConsoleArgs::split(const std::string &args) {
+    std::vector<std::string> result;
+    std::regex re(R"((\"[^\"]*\")|(\S+))");
+    std::sregex_iterator it(args.begin(), args.end(), re);
+    std::sregex_iterator end;
+    while (it != end) {
+        std::smatch match = *it;
+        if (match[1].matched) {
+            result.push_back(match[1].str().substr(1, match[1].str().length() - 2)); // Remove quotes
+        } else {
+            result.push_back(match[2].str());
+        }
+        ++it;
+    }
+    return result;
+}
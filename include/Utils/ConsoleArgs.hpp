@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// console command line parsing, kept apart from the Console so it builds without GL
+namespace ConsoleArgs {
+    // strips leading and trailing spaces
+    std::string trim(const std::string &str);
+    // splits on whitespace, "quoted text" stays one argument without its quotes
+    std::vector<std::string> split(const std::string &args);
+};
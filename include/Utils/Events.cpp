@@ -0,0 +1,58 @@
+#include "Utils/Events.hpp"
+#include <algorithm>
+
+EventQueue *EventQueue::instance = nullptr;
+
+void EventQueue::stage(const std::vector<BodyEvent> &found)
+{
+    if (found.empty())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    staged.insert(staged.end(), found.begin(), found.end());
+}
+
+void EventQueue::commit()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (staged.empty())
+        return;
+    std::sort(staged.begin(), staged.end(), [](const BodyEvent &a, const BodyEvent &b) {
+        if (a.time != b.time)
+            return a.time < b.time;
+        if (a.body.id != b.body.id)
+            return a.body.id < b.body.id;
+        return a.threshold < b.threshold;
+    });
+    events.insert(events.end(), staged.begin(), staged.end());
+    pushed += staged.size();
+    staged.clear();
+    if (events.size() > Capacity)
+    {
+        size_t excess = events.size() - Capacity;
+        events.erase(events.begin(), events.begin() + excess);
+        dropped += excess;
+    }
+}
+
+bool EventQueue::poll(BodyEvent &event)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (events.empty())
+        return false;
+    event = events.front();
+    events.pop_front();
+    return true;
+}
+
+void EventQueue::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    staged.clear();
+    events.clear();
+}
+
+size_t EventQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return events.size();
+}
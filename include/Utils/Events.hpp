@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "Utils/BodyStore.hpp"
+
+// a body crossing an altitude, located inside the step it happened in
+struct BodyEvent {
+    enum class Kind : uint8_t {
+        Impact,  // came down to the ellipsoid, the body was stopped there
+        Altitude // crossed one of the BodyStore altitude thresholds
+    };
+    Kind kind = Kind::Impact;
+    bool rising = false;         // crossed going up, impacts never do
+    BodyHandle body;
+    double time = 0.0;           // sim seconds of the crossing
+    double threshold = 0.0;      // meters above the ellipsoid, 0 for impacts
+    double x = 0.0, y = 0.0, z = 0.0;
+    double latitude = 0.0, longitude = 0.0; // degrees
+    double speed = 0.0;          // engine units per second at the crossing
+};
+
+/*
+    events found by BodyStore::step, oldest first
+
+    the step's slices stage what they found and the step commits it sorted
+    by time then body, so the order does not depend on the threads. nothing is required to
+    poll the queue : past capacity the oldest events are dropped and counted
+*/
+class EventQueue {
+public:
+        EventQueue(const EventQueue &obj) = delete;
+        static EventQueue *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new EventQueue();
+            return instance;
+        }
+
+    // adds events found by one slice of a step, from any thread
+    void stage(const std::vector<BodyEvent> &found);
+    // sorts the staged events into the queue, once the step is done
+    void commit();
+    // takes the oldest event, false when empty
+    bool poll(BodyEvent &event);
+    void clear();
+
+    size_t size() const;
+    // events pushed since the start, and the ones dropped for capacity
+    size_t getPushed() const { return pushed; }
+    size_t getDropped() const { return dropped; }
+
+    static constexpr size_t Capacity = 1 << 16;
+
+private:
+    static EventQueue *instance;
+    EventQueue() = default;
+
+    mutable std::mutex mutex;
+    std::vector<BodyEvent> staged;
+    std::deque<BodyEvent> events;
+    size_t pushed = 0;
+    size_t dropped = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include "Utils/Physics.hpp"
+
+/*
+    force stacks composed at compile time
+
+    a ForceSet holds its terms by value and applies them with a fold, so
+    Gravity + Drag + Lift is one inlined kernel with no virtual call and no
+    heap allocation. ForceModel is the closed list of sets a body can carry,
+    add a set here to give a new body type its own kernel
+*/
+
+// terms with a static batched flag are evaluated over many bodies at once by the BodyStore
+template <class Term, class = void>
+struct IsBatched : std::false_type {};
+template <class Term>
+struct IsBatched<Term, std::void_t<decltype(Term::batched)>> : std::bool_constant<Term::batched> {};
+
+// terms the set can trade for a Kepler conic above the atmosphere, see BodyStore::setKeplerAltitude
+template <class Term, class = void>
+struct IsKeplerian : std::false_type {};
+template <class Term>
+struct IsKeplerian<Term, std::void_t<decltype(Term::keplerian)>> : std::bool_constant<Term::keplerian> {};
+template <class Term, class = void>
+struct VanishesInVacuum : std::false_type {};
+template <class Term>
+struct VanishesInVacuum<Term, std::void_t<decltype(Term::vanishesInVacuum)>> : std::bool_constant<Term::vanishesInVacuum> {};
+
+template <class... Terms>
+class ForceSet {
+public:
+    static constexpr bool batched = (IsBatched<Terms>::value || ...);
+    // one keplerian term and nothing else that acts outside the atmosphere
+    static constexpr bool conic = (IsKeplerian<Terms>::value || ...) &&
+                                  ((IsKeplerian<Terms>::value || VanishesInVacuum<Terms>::value) && ...);
+
+    ForceSet(Terms... terms) : terms(terms...) {}
+
+    // every term, for a single body
+    void apply(Position& position, double mass, double deltaTime) const {
+        std::apply([&](const Terms&... term) { (term.apply(position, mass, deltaTime), ...); }, terms);
+    }
+
+    // the terms left once the batched ones are done for the slice
+    void applyUnbatched(Position& position, double mass, double deltaTime) const {
+        std::apply([&](const Terms&... term) { (applyUnbatchedTerm(term, position, mass, deltaTime), ...); }, terms);
+    }
+
+private:
+    template <class Term>
+    static void applyUnbatchedTerm(const Term& term, Position& position, double mass, double deltaTime) {
+        if constexpr (!IsBatched<Term>::value)
+            term.apply(position, mass, deltaTime);
+    }
+
+    std::tuple<Terms...> terms;
+};
+
+namespace ForceModels {
+    using None = ForceSet<>;
+    using Ballistic = ForceSet<GravityForce>;
+    using Atmospheric = ForceSet<GravityForce, DragForce>;
+    using Aerodynamic = ForceSet<GravityForce, DragForce, LiftForce>;
+    using Powered = ForceSet<GravityForce, DragForce, ThrustForce>;
+    using Orbital = ForceSet<HarmonicGravityForce>;
+    using OrbitalDrag = ForceSet<HarmonicGravityForce, DragForce>;
+};
+
+using ForceModel = std::variant<ForceModels::None, ForceModels::Ballistic, ForceModels::Atmospheric,
+                                ForceModels::Aerodynamic, ForceModels::Powered, ForceModels::Orbital,
+                                ForceModels::OrbitalDrag>;
+
+inline bool hasForces(const ForceModel& model) {
+    return !std::holds_alternative<ForceModels::None>(model);
+}
+
+inline bool hasBatchedForces(const ForceModel& model) {
+    return std::visit([](const auto& set) { return set.batched; }, model);
+}
+
+inline bool followsConic(const ForceModel& model) {
+    return std::visit([](const auto& set) { return set.conic; }, model);
+}
+
+// one switch on the set, then the set's fused kernel
+inline void applyForces(const ForceModel& model, Position& position, double mass, double deltaTime) {
+    std::visit([&](const auto& set) { set.apply(position, mass, deltaTime); }, model);
+}
+
+inline void applyUnbatchedForces(const ForceModel& model, Position& position, double mass, double deltaTime) {
+    std::visit([&](const auto& set) { set.applyUnbatched(position, mass, deltaTime); }, model);
+}
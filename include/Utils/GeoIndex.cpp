@@ -0,0 +1,523 @@
+#include "Utils/GeoIndex.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/Trace.hpp"
+#include "Utils/PerfCounters.hpp"
+#include "static/wgs84.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+GeoIndex *GeoIndex::instance = nullptr;
+
+namespace {
+    constexpr uint64_t idMask = 0xFFFFFFFFull;
+
+    // spreads the low 16 bits to the even bits
+    uint32_t spread(uint32_t v)
+    {
+        v = (v | v << 8) & 0x00FF00FFu;
+        v = (v | v << 4) & 0x0F0F0F0Fu;
+        v = (v | v << 2) & 0x33333333u;
+        v = (v | v << 1) & 0x55555555u;
+        return v;
+    }
+
+    uint32_t interleave(uint32_t i, uint32_t j)
+    {
+        return spread(i) | spread(j) << 1;
+    }
+
+    // unit vector of face coordinates, faces are +X +Y +Z -X -Y -Z
+    void faceToVector(uint32_t face, double u, double v, double out[3])
+    {
+        uint32_t axis = face % 3;
+        out[axis] = face < 3 ? 1.0 : -1.0;
+        out[(axis + 1) % 3] = u;
+        out[(axis + 2) % 3] = v;
+        double length = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+        for (int k = 0; k < 3; k++)
+            out[k] /= length;
+    }
+
+    double dot(const double a[3], const double b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    double angleBetween(const double a[3], const double b[3])
+    {
+        return std::acos(std::clamp(dot(a, b), -1.0, 1.0));
+    }
+
+    // geodetic surface normal of (lat, lon) degrees
+    void normalAt(double lat, double lon, double out[3])
+    {
+        // the batch normal takes longitude first, like the BodyStore geodetic columns
+        WGS84::surfaceNormal(&lon, &lat, &out[0], &out[1], &out[2], 1);
+    }
+
+    // a quadtree node's center, corners and the angle of its bounding cap
+    struct Cell {
+        double center[3];
+        double corners[4][3];
+        double angle;
+
+        Cell(uint32_t face, uint32_t level, uint32_t i, uint32_t j)
+        {
+            // face coordinates run over [-1, 1]
+            double size = 2.0 / (1u << level);
+            double u[3] = {i * size - 1.0, (i + 0.5) * size - 1.0, (i + 1) * size - 1.0};
+            double v[3] = {j * size - 1.0, (j + 0.5) * size - 1.0, (j + 1) * size - 1.0};
+            faceToVector(face, u[1], v[1], center);
+            faceToVector(face, u[0], v[0], corners[0]);
+            faceToVector(face, u[2], v[0], corners[1]);
+            faceToVector(face, u[2], v[2], corners[2]);
+            faceToVector(face, u[0], v[2], corners[3]);
+            // edges are great circle arcs, so the cap through the farthest corner holds the whole cell
+            angle = 0.0;
+            for (const auto &corner : corners)
+                angle = std::max(angle, angleBetween(center, corner));
+        }
+    };
+
+    // slack on the node rejection so rounding never drops a body on the boundary
+    constexpr double angleSlack = 1e-9;
+
+    struct CapRegion {
+        double center[3];
+        double angle, cosAngle;
+
+        CapRegion(double lat, double lon, double radians)
+        {
+            normalAt(lat, lon, center);
+            angle = std::min(radians, M_PI);
+            cosAngle = std::cos(angle);
+        }
+
+        bool mayIntersect(const Cell &cell) const
+        {
+            return angleBetween(center, cell.center) <= angle + cell.angle + angleSlack;
+        }
+
+        // a cap under a hemisphere is convex, holding the 4 corners means holding the cell
+        bool covers(const Cell &cell) const
+        {
+            if (angle >= M_PI / 2)
+                return false;
+            for (const auto &corner : cell.corners)
+                if (dot(center, corner) < cosAngle)
+                    return false;
+            return true;
+        }
+
+        bool contains(const double n[3]) const { return dot(center, n) >= cosAngle; }
+    };
+
+    struct BoxRegion {
+        CapRegion bound;
+        double latMin, latMax, lonMin, lonSpan;
+
+        BoxRegion(double latMin, double lonMin, double latMax, double lonMax)
+            : bound(0.0, 0.0, M_PI), latMin(latMin), latMax(latMax), lonMin(lonMin)
+        {
+            lonSpan = lonMax - lonMin;
+            if (lonSpan < 0.0)
+                lonSpan += 360.0;
+            lonSpan = std::min(lonSpan, 360.0);
+
+            // distances from the box center peak at the corners while the box spans half the globe or less
+            if (lonSpan <= 180.0)
+            {
+                double center = lonMin + lonSpan / 2;
+                bound = CapRegion(0.5 * (latMin + latMax), center, 0.0);
+                double farthest = 0.0;
+                for (double lat : {latMin, latMax})
+                    for (double lon : {lonMin, lonMin + lonSpan})
+                    {
+                        double corner[3];
+                        normalAt(lat, lon, corner);
+                        farthest = std::max(farthest, angleBetween(bound.center, corner));
+                    }
+                bound.angle = farthest;
+                bound.cosAngle = std::cos(farthest);
+            }
+        }
+
+        bool mayIntersect(const Cell &cell) const { return bound.mayIntersect(cell); }
+        bool covers(const Cell &) const { return false; }
+
+        bool contains(const double n[3]) const
+        {
+            double lat = glm::degrees(std::asin(std::clamp(n[2], -1.0, 1.0)));
+            if (lat < latMin || lat > latMax)
+                return false;
+            double offset = std::fmod(glm::degrees(std::atan2(n[1], n[0])) - lonMin, 360.0);
+            if (offset < 0.0)
+                offset += 360.0;
+            return offset <= lonSpan;
+        }
+    };
+
+    // vertices go through the gnomonic projection around the polygon's center,
+    // it maps great circles to straight lines so the inside test is the planar one
+    struct PolygonRegion {
+        CapRegion bound;
+        double east[3], north[3];
+        std::vector<double> px, py;
+        bool valid = false;
+
+        explicit PolygonRegion(const std::vector<glm::dvec2> &vertices) : bound(0.0, 0.0, M_PI)
+        {
+            if (vertices.size() < 3)
+                return;
+            std::vector<std::array<double, 3>> normals(vertices.size());
+            double sum[3] = {0.0, 0.0, 0.0};
+            for (size_t k = 0; k < vertices.size(); k++)
+            {
+                normalAt(vertices[k].x, vertices[k].y, normals[k].data());
+                for (int c = 0; c < 3; c++)
+                    sum[c] += normals[k][c];
+            }
+            double length = std::sqrt(dot(sum, sum));
+            if (length == 0.0)
+                return;
+            double farthest = 0.0;
+            for (int c = 0; c < 3; c++)
+                bound.center[c] = sum[c] / length;
+            for (const auto &normal : normals)
+                farthest = std::max(farthest, angleBetween(bound.center, normal.data()));
+            if (farthest >= M_PI / 2)
+                return;
+            bound.angle = farthest;
+            bound.cosAngle = std::cos(farthest);
+
+            // tangent plane basis at the center
+            const double *c = bound.center;
+            double up[3] = {0.0, 0.0, 1.0};
+            if (std::fabs(c[2]) > 0.9)
+                up[0] = 1.0, up[2] = 0.0;
+            east[0] = up[1] * c[2] - up[2] * c[1];
+            east[1] = up[2] * c[0] - up[0] * c[2];
+            east[2] = up[0] * c[1] - up[1] * c[0];
+            double eastLength = std::sqrt(dot(east, east));
+            for (int k = 0; k < 3; k++)
+                east[k] /= eastLength;
+            north[0] = c[1] * east[2] - c[2] * east[1];
+            north[1] = c[2] * east[0] - c[0] * east[2];
+            north[2] = c[0] * east[1] - c[1] * east[0];
+
+            for (const auto &normal : normals)
+            {
+                double x, y;
+                project(normal.data(), x, y);
+                px.push_back(x);
+                py.push_back(y);
+            }
+            valid = true;
+        }
+
+        void project(const double n[3], double &x, double &y) const
+        {
+            double d = dot(n, bound.center);
+            x = dot(n, east) / d;
+            y = dot(n, north) / d;
+        }
+
+        bool mayIntersect(const Cell &cell) const { return bound.mayIntersect(cell); }
+        bool covers(const Cell &) const { return false; }
+
+        bool contains(const double n[3]) const
+        {
+            if (!bound.contains(n))
+                return false;
+            double x, y;
+            project(n, x, y);
+            bool inside = false;
+            for (size_t a = 0, b = px.size() - 1; a < px.size(); b = a++)
+                if ((py[a] > y) != (py[b] > y) && x < (px[b] - px[a]) * (y - py[a]) / (py[b] - py[a]) + px[a])
+                    inside = !inside;
+            return inside;
+        }
+    };
+
+    // LSD radix sort of the entries on their 31 bit key, stable so equal keys keep the body order
+    void sortByKey(std::vector<uint64_t> &entries, std::vector<uint64_t> &scratch)
+    {
+        const int bits = 11;
+        const size_t buckets = size_t(1) << bits;
+        std::vector<size_t> count(buckets);
+        scratch.resize(entries.size());
+        for (int shift = 32; shift < 64; shift += bits)
+        {
+            std::fill(count.begin(), count.end(), 0);
+            for (uint64_t entry : entries)
+                count[(entry >> shift) & (buckets - 1)]++;
+            size_t total = 0;
+            for (auto &c : count)
+            {
+                size_t n = c;
+                c = total;
+                total += n;
+            }
+            for (uint64_t entry : entries)
+                scratch[count[(entry >> shift) & (buckets - 1)]++] = entry;
+            entries.swap(scratch);
+        }
+    }
+
+    bool keyLess(uint64_t a, uint64_t b)
+    {
+        return (a >> 32) < (b >> 32);
+    }
+}
+
+uint32_t GeoIndex::keyOf(const double n[3])
+{
+    double ax = std::fabs(n[0]), ay = std::fabs(n[1]), az = std::fabs(n[2]);
+    uint32_t axis = ax >= ay ? (ax >= az ? 0 : 2) : (ay >= az ? 1 : 2);
+    uint32_t face = axis + (n[axis] < 0.0 ? 3 : 0);
+
+    // face coordinates in [-1, 1] scaled straight to cells
+    const uint32_t cells = 1u << MaxLevel;
+    double scale = 0.5 * cells / std::fabs(n[axis]);
+    double offset = 0.5 * cells;
+    uint32_t i = std::min(static_cast<uint32_t>(n[(axis + 1) % 3] * scale + offset), cells - 1);
+    uint32_t j = std::min(static_cast<uint32_t>(n[(axis + 2) % 3] * scale + offset), cells - 1);
+    return face << (2 * MaxLevel) | interleave(i, j);
+}
+
+void GeoIndex::update(const BodyStore &bodies)
+{
+    TRACE_SCOPE("geo index");
+    size_t count = bodies.size();
+    size_t ids = bodies.handleCount();
+    // the store was cleared, its ids start over
+    if (ids < keyById.size())
+        clear();
+    keyById.resize(ids, NoKey);
+    for (auto column : {&nx, &ny, &nz})
+        column->resize(ids);
+    for (auto column : {&lastX, &lastY, &lastZ})
+        column->resize(ids, std::nan(""));
+    freshKey.resize(count);
+
+    // sleepers past the awake bodies are visited only if they fell asleep since the last update
+    size_t active = bodies.getActiveCount();
+    size_t chunks = (count + grain - 1) / grain;
+    changed.resize(chunks);
+    Utils::JobSystem::getInstance()->parallelFor(chunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+        TRACE_SCOPE("geo chunk");
+        thread_local std::vector<double> geo[5];
+        for (size_t chunk = chunkBegin; chunk < chunkEnd; chunk++)
+        {
+            // bodies that did not move keep their key, resting ones cost a compare
+            std::vector<uint32_t> &moving = changed[chunk];
+            moving.clear();
+            for (size_t i = chunk * grain, end = std::min(count, (chunk + 1) * grain); i < end; i++)
+            {
+                if (i >= active && bodies.sleptAt[i] < lastTime)
+                    continue;
+                uint32_t id = bodies.handleOf(i).id;
+                if (bodies.x[i] != lastX[id] || bodies.y[i] != lastY[id] || bodies.z[i] != lastZ[id] || keyById[id] == NoKey)
+                    moving.push_back(i);
+            }
+            if (moving.empty())
+                continue;
+
+            for (auto &column : geo)
+                column.resize(moving.size());
+            for (size_t k = 0; k < moving.size(); k++)
+            {
+                geo[0][k] = bodies.lat[moving[k]];
+                geo[1][k] = bodies.lon[moving[k]];
+            }
+            // the lat column holds the longitude, the order the batch normal takes (see BodyStore::updateGeodetic)
+            {
+                PerfCounters::Scope perf(PerfCounters::Geodesy, moving.size());
+                WGS84::surfaceNormal(geo[0].data(), geo[1].data(), geo[2].data(), geo[3].data(), geo[4].data(), moving.size());
+            }
+            for (size_t k = 0; k < moving.size(); k++)
+            {
+                size_t i = moving[k];
+                uint32_t id = bodies.handleOf(i).id;
+                double n[3] = {geo[2][k], geo[3][k], geo[4][k]};
+                nx[id] = n[0];
+                ny[id] = n[1];
+                nz[id] = n[2];
+                lastX[id] = bodies.x[i];
+                lastY[id] = bodies.y[i];
+                lastZ[id] = bodies.z[i];
+                freshKey[i] = keyOf(n);
+            }
+        }
+    });
+    lastTime = bodies.getTime();
+
+    moved.clear();
+    stale.clear();
+    for (const auto &moving : changed)
+        for (uint32_t i : moving)
+        {
+            uint32_t id = bodies.handleOf(i).id;
+            if (keyById[id] != freshKey[i])
+            {
+                if (keyById[id] != NoKey)
+                    stale.push_back(static_cast<uint64_t>(keyById[id]) << 32 | id);
+                keyById[id] = freshKey[i];
+                moved.push_back(static_cast<uint64_t>(freshKey[i]) << 32 | id);
+            }
+        }
+
+    if (entries.empty() || moved.size() * 4 > count)
+    {
+        // most of the index moved, sorting everything is cheaper than merging
+        for (size_t id = 0; id < ids; id++)
+            if (!bodies.contains(BodyHandle{static_cast<uint32_t>(id)}))
+                keyById[id] = NoKey;
+        entries.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t id = bodies.handleOf(i).id;
+            entries[i] = static_cast<uint64_t>(keyById[id]) << 32 | id;
+        }
+        sortByKey(entries, scratch);
+        lastMoved = count;
+        return;
+    }
+
+    // the movers' old entries are found by key and blanked, the key stays so the array stays sorted
+    size_t removed = 0;
+    for (uint64_t entry : stale)
+    {
+        auto it = std::lower_bound(entries.begin(), entries.end(), entry & ~idMask);
+        while (it != entries.end() && (*it >> 32) == (entry >> 32) && *it != entry)
+            ++it;
+        if (it != entries.end() && *it == entry)
+        {
+            *it |= idMask;
+            removed++;
+        }
+    }
+
+    if (entries.size() - removed > count - moved.size())
+    {
+        // more entries left than bodies that stayed : some were destroyed, find them by id
+        size_t kept = 0;
+        for (uint64_t entry : entries)
+        {
+            uint32_t id = entry & idMask;
+            if (id == idMask)
+                continue;
+            if (!bodies.contains(BodyHandle{id}))
+                keyById[id] = NoKey;
+            else if (keyById[id] == entry >> 32)
+                entries[kept++] = entry;
+        }
+        entries.resize(kept);
+    }
+    else
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](uint64_t entry) { return (entry & idMask) == idMask; }),
+                      entries.end());
+
+    std::sort(moved.begin(), moved.end(), keyLess);
+    scratch.resize(entries.size() + moved.size());
+    std::merge(entries.begin(), entries.end(), moved.begin(), moved.end(), scratch.begin(), keyLess);
+    entries.swap(scratch);
+    lastMoved = moved.size();
+}
+
+void GeoIndex::clear()
+{
+    entries.clear();
+    keyById.clear();
+    for (auto column : {&lastX, &lastY, &lastZ})
+        column->clear();
+    lastTime = -std::numeric_limits<double>::infinity();
+    lastMoved = 0;
+}
+
+template <class Region>
+void GeoIndex::query(const Region &region, std::vector<BodyHandle> &out) const
+{
+    // a node holding this few bodies is cheaper to test one by one than to split
+    const size_t scanLimit = 16;
+
+    struct Node {
+        uint32_t face, level, i, j;
+    };
+    std::vector<Node> stack;
+    for (uint32_t face = 6; face-- > 0;)
+        stack.push_back({face, 0, 0, 0});
+
+    auto appendIf = [&](auto first, auto last, bool test) {
+        for (auto it = first; it != last; ++it)
+        {
+            uint32_t id = *it & idMask;
+            double n[3] = {nx[id], ny[id], nz[id]};
+            if (!test || region.contains(n))
+                out.push_back(BodyHandle{id});
+        }
+    };
+
+    while (!stack.empty())
+    {
+        Node node = stack.back();
+        stack.pop_back();
+
+        // the node's leaves are one run of keys
+        uint32_t shift = 2 * (MaxLevel - node.level);
+        uint64_t low = (static_cast<uint64_t>(node.face) << 2 * MaxLevel | static_cast<uint64_t>(interleave(node.i, node.j)) << shift);
+        uint64_t high = low + (uint64_t(1) << shift);
+        auto first = std::lower_bound(entries.begin(), entries.end(), low << 32);
+        auto last = std::lower_bound(first, entries.end(), high << 32);
+        if (first == last)
+            continue;
+
+        Cell cell(node.face, node.level, node.i, node.j);
+        if (!region.mayIntersect(cell))
+            continue;
+        if (region.covers(cell))
+        {
+            appendIf(first, last, false);
+            continue;
+        }
+        if (static_cast<size_t>(last - first) <= scanLimit || node.level == MaxLevel)
+        {
+            appendIf(first, last, true);
+            continue;
+        }
+        // pushed in reverse so children pop in key order
+        for (uint32_t child = 4; child-- > 0;)
+            stack.push_back({node.face, node.level + 1, node.i * 2 + (child & 1), node.j * 2 + (child >> 1)});
+    }
+}
+
+void GeoIndex::radius(double lat, double lon, double km, std::vector<BodyHandle> &out) const
+{
+    out.clear();
+    if (km < 0.0)
+        return;
+    query(CapRegion(lat, lon, km * 1000.0 / MeanRadiusMeters), out);
+}
+
+void GeoIndex::box(double latMin, double lonMin, double latMax, double lonMax, std::vector<BodyHandle> &out) const
+{
+    out.clear();
+    if (latMin > latMax)
+        return;
+    query(BoxRegion(latMin, lonMin, latMax, lonMax), out);
+}
+
+bool GeoIndex::polygon(const std::vector<glm::dvec2> &vertices, std::vector<BodyHandle> &out) const
+{
+    out.clear();
+    PolygonRegion region(vertices);
+    if (!region.valid)
+    {
+        std::cerr << "ERROR::GEOINDEX: Polygon needs 3 or more vertices within a hemisphere" << std::endl;
+        return false;
+    }
+    query(region, out);
+    return true;
+}
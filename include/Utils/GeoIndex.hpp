@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Utils/BodyStore.hpp"
+
+/*
+    geodetic index of the BodyStore bodies for radius, box and polygon queries
+
+    a body's geodetic surface normal is projected on the faces of a cube
+    and each face is a quadtree down to level 14, 250 to 800 m cells. leaf
+    cells are numbered face then Morton order so every quadtree node owns
+    one contiguous run of keys, and the index is a single sorted array of
+    (cell key, handle id) entries : a node's bodies are found with two
+    binary searches, no tree to maintain.
+
+    update() only recomputes the normal and key of bodies whose position
+    changed since the last call (one SIMD normal batch per slice), and only
+    re-sorts the ones that changed cell : their old entries are looked up
+    by key and dropped, the movers merged back in. when too many moved it falls back to
+    a full radix sort. bodies that were already asleep at the last call
+    are not looked at, they cannot have moved.
+
+    queries descend from the 6 faces, skip nodes without bodies or outside
+    the region, take whole nodes the region covers and test single bodies
+    once a node holds only a few. distances are great circle distances on
+    the mean earth sphere between geodetic lat/lon, results reflect the
+    bodies as they were at the last update()
+*/
+class GeoIndex {
+public:
+        GeoIndex(const GeoIndex &obj) = delete;
+        static GeoIndex *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new GeoIndex();
+            return instance;
+        }
+
+    // brings the index to the bodies' current geodetic cache, call after BodyStore::step
+    void update(const BodyStore &bodies);
+    void clear();
+
+    // bodies within km of (lat, lon), degrees, appended to out in cell order
+    void radius(double lat, double lon, double km, std::vector<BodyHandle> &out) const;
+    // bodies inside the lat/lon box, lon ranges may cross the antimeridian (lonMin > lonMax)
+    void box(double latMin, double lonMin, double latMax, double lonMax, std::vector<BodyHandle> &out) const;
+    // bodies inside the polygon of (lat, lon) vertices joined by great circle arcs
+    // the polygon must fit in a hemisphere, else prints the reason and returns false
+    bool polygon(const std::vector<glm::dvec2> &vertices, std::vector<BodyHandle> &out) const;
+
+    size_t size() const { return entries.size(); }
+    // bodies re-inserted by the last update, size() when it rebuilt
+    size_t getLastMoved() const { return lastMoved; }
+
+    // mean earth radius the km of radius() are measured on
+    static constexpr double MeanRadiusMeters = 6371008.8;
+    static constexpr int MaxLevel = 14;
+
+private:
+    static GeoIndex *instance;
+    GeoIndex() = default;
+
+    static constexpr uint32_t NoKey = UINT32_MAX;
+    // bodies per parallel job
+    static constexpr size_t grain = 2048;
+
+    // leaf cell key of a unit vector
+    static uint32_t keyOf(const double n[3]);
+
+    template <class Region>
+    void query(const Region &region, std::vector<BodyHandle> &out) const;
+
+    // (leaf key << 32 | handle id), sorted by key
+    std::vector<uint64_t> entries;
+    std::vector<uint64_t> scratch;
+    // per handle id : leaf key in the index (NoKey = not indexed),
+    // unit normal and the ECEF position they were computed from
+    std::vector<uint32_t> keyById;
+    std::vector<double> nx, ny, nz;
+    std::vector<double> lastX, lastY, lastZ;
+    // per body index, filled by the parallel pass of update for the bodies listed in changed
+    std::vector<uint32_t> freshKey;
+    std::vector<std::vector<uint32_t>> changed;
+    // entries to insert and entries to drop, same layout as entries
+    std::vector<uint64_t> moved, stale;
+    // BodyStore time of the last update, bodies asleep since before it are skipped
+    double lastTime = -std::numeric_limits<double>::infinity();
+    size_t lastMoved = 0;
+};
@@ -0,0 +1,277 @@
+#include "Utils/GravityField.hpp"
+#include "static/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+GravityField *GravityField::instance = nullptr;
+
+namespace {
+    // EGM96 C20, enough for the built-in J2 field
+    constexpr double egm96C20 = -4.84165371736e-04;
+
+    // log of the full normalization factor, kept in logs so high degrees do not overflow the factorials
+    double logNorm(int n, int m)
+    {
+        return 0.5 * (std::log((m == 0 ? 1.0 : 2.0) * (2 * n + 1)) + std::lgamma(n - m + 1.0) - std::lgamma(n + m + 1.0));
+    }
+
+    // N(n1,m1) / N(n2,m2)
+    double normRatio(int n1, int m1, int n2, int m2)
+    {
+        return std::exp(logNorm(n1, m1) - logNorm(n2, m2));
+    }
+
+    // reads numbers written with Fortran exponents too (EGM96 files use 0.1D-05)
+    bool parseNumber(std::string text, double &value)
+    {
+        std::replace(text.begin(), text.end(), 'D', 'E');
+        std::replace(text.begin(), text.end(), 'd', 'e');
+        try
+        {
+            size_t used = 0;
+            value = std::stod(text, &used);
+            return used == text.size();
+        }
+        catch (const std::exception &e)
+        {
+            return false;
+        }
+    }
+}
+
+GravityField::GravityField()
+{
+    maxDegree = 2;
+    C.assign(index(maxDegree + 1, 0), 0.0);
+    S.assign(index(maxDegree + 1, 0), 0.0);
+    C[index(0, 0)] = 1.0;
+    C[index(2, 0)] = egm96C20;
+    source = "built-in J2";
+    degree = maxDegree;
+    prepare();
+}
+
+bool GravityField::load(const std::string &path, int newDegree)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "ERROR::GRAVITY: Could not open " << path << std::endl;
+        return false;
+    }
+
+    // ICGEM headers may state their own constants, in meters
+    double fileGM = 3.986004418e14;
+    double fileRadius = 6378137.0;
+    struct Term {
+        int n, m;
+        double c, s;
+    };
+    std::vector<Term> terms;
+    int fileDegree = 0;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (iss >> token)
+            tokens.push_back(token);
+        if (tokens.empty())
+            continue;
+
+        if (tokens[0] == "earth_gravity_constant" && tokens.size() >= 2)
+        {
+            parseNumber(tokens[1], fileGM);
+            continue;
+        }
+        if (tokens[0] == "radius" && tokens.size() >= 2)
+        {
+            parseNumber(tokens[1], fileRadius);
+            continue;
+        }
+
+        // "gfc n m C S ..." (ICGEM) or "n m C S ..." (EGM96 style), anything else is header
+        size_t first = tokens[0] == "gfc" ? 1 : 0;
+        if (tokens.size() < first + 4)
+            continue;
+        double n, m, c, s;
+        if (!parseNumber(tokens[first], n) || !parseNumber(tokens[first + 1], m) ||
+            !parseNumber(tokens[first + 2], c) || !parseNumber(tokens[first + 3], s))
+            continue;
+        if (n < 0 || m < 0 || m > n)
+            continue;
+        terms.push_back({static_cast<int>(n), static_cast<int>(m), c, s});
+        fileDegree = std::max(fileDegree, static_cast<int>(n));
+    }
+
+    if (terms.empty())
+    {
+        std::cerr << "ERROR::GRAVITY: No coefficients in " << path << std::endl;
+        return false;
+    }
+
+    C.assign(index(fileDegree + 1, 0), 0.0);
+    S.assign(index(fileDegree + 1, 0), 0.0);
+    // EGM files usually start at degree 2, the central term is implied
+    C[index(0, 0)] = 1.0;
+    for (const Term &term : terms)
+    {
+        C[index(term.n, term.m)] = term.c;
+        S[index(term.n, term.m)] = term.s;
+    }
+
+    gm = fileGM * WGS84::UnitToMeterRatio * WGS84::UnitToMeterRatio * WGS84::UnitToMeterRatio;
+    radius = fileRadius * WGS84::UnitToMeterRatio;
+    maxDegree = fileDegree;
+    source = path;
+    degree = newDegree < 0 ? maxDegree : std::min(newDegree, maxDegree);
+    prepare();
+    return true;
+}
+
+void GravityField::setDegree(int newDegree)
+{
+    degree = std::clamp(newDegree, 0, maxDegree);
+    prepare();
+}
+
+void GravityField::prepare()
+{
+    // the recursion runs one degree past the field, the acceleration needs V(n+1, m+1)
+    int top = degree + 1;
+    diagonal.assign(top + 1, 0.0);
+    alpha.assign(index(top + 1, 0), 0.0);
+    beta.assign(index(top + 1, 0), 0.0);
+    for (int m = 1; m <= top; m++)
+        diagonal[m] = (2 * m - 1) * normRatio(m, m, m - 1, m - 1);
+    for (int m = 0; m <= top; m++)
+        for (int n = m + 1; n <= top; n++)
+        {
+            alpha[index(n, m)] = (2.0 * n - 1) / (n - m) * normRatio(n, m, n - 1, m);
+            if (n >= m + 2)
+                beta[index(n, m)] = (n + m - 1.0) / (n - m) * normRatio(n, m, n - 2, m);
+        }
+
+    size_t terms = index(degree + 1, 0);
+    for (auto column : {&cPlus, &sPlus, &cMinus, &sMinus, &cZero, &sZero})
+        column->assign(terms, 0.0);
+    for (int n = 0; n <= degree; n++)
+    {
+        double c = C[index(n, 0)];
+        cPlus[index(n, 0)] = c * normRatio(n, 0, n + 1, 1);
+        cZero[index(n, 0)] = c * (n + 1) * normRatio(n, 0, n + 1, 0);
+        for (int m = 1; m <= n; m++)
+        {
+            size_t i = index(n, m);
+            double plus = 0.5 * normRatio(n, m, n + 1, m + 1);
+            double minus = 0.5 * (n - m + 2.0) * (n - m + 1.0) * normRatio(n, m, n + 1, m - 1);
+            double zero = (n - m + 1.0) * normRatio(n, m, n + 1, m);
+            cPlus[i] = C[i] * plus;
+            sPlus[i] = S[i] * plus;
+            cMinus[i] = C[i] * minus;
+            sMinus[i] = S[i] * minus;
+            cZero[i] = C[i] * zero;
+            sZero[i] = S[i] * zero;
+        }
+    }
+}
+
+void GravityField::acceleration(const double *x, const double *y, const double *z,
+                                double *ax, double *ay, double *az, size_t count) const
+{
+    using namespace Simd;
+
+    int top = degree + 1;
+    thread_local std::vector<Pack> V, W;
+    V.resize(index(top + 1, 0));
+    W.resize(index(top + 1, 0));
+
+    Pack R = set(radius);
+    Pack scale = set(gm / (radius * radius));
+
+    for (size_t i = 0; i < count; i += width)
+    {
+        // the tail repeats the last point so every lane stays away from the origin
+        double px[width], py[width], pz[width];
+        for (size_t k = 0; k < width; k++)
+        {
+            size_t j = std::min(i + k, count - 1);
+            px[k] = x[j];
+            py[k] = y[j];
+            pz[k] = z[j];
+        }
+        Pack X = Simd::load(px), Y = Simd::load(py), Z = Simd::load(pz);
+
+        Pack r2 = X * X + Y * Y + Z * Z;
+        Pack rho = R / r2;
+        Pack xr = X * rho, yr = Y * rho, zr = Z * rho;
+        Pack rr = R * rho;
+
+        V[0] = R / sqrt(r2);
+        W[0] = set(0.0);
+        for (int m = 0; m <= top; m++)
+        {
+            size_t mm = index(m, m);
+            if (m > 0)
+            {
+                size_t prev = index(m - 1, m - 1);
+                Pack d = set(diagonal[m]);
+                V[mm] = d * (xr * V[prev] - yr * W[prev]);
+                W[mm] = d * (xr * W[prev] + yr * V[prev]);
+            }
+            if (m + 1 <= top)
+            {
+                size_t next = index(m + 1, m);
+                Pack a = set(alpha[next]) * zr;
+                V[next] = a * V[mm];
+                W[next] = a * W[mm];
+            }
+            for (int n = m + 2; n <= top; n++)
+            {
+                size_t nm = index(n, m), n1 = index(n - 1, m), n2 = index(n - 2, m);
+                Pack a = set(alpha[nm]) * zr;
+                Pack b = set(beta[nm]) * rr;
+                V[nm] = a * V[n1] - b * V[n2];
+                W[nm] = a * W[n1] - b * W[n2];
+            }
+        }
+
+        Pack sx = set(0.0), sy = set(0.0), sz = set(0.0);
+        for (int n = 0; n <= degree; n++)
+        {
+            size_t up = index(n + 1, 0);
+            Pack cp = set(cPlus[index(n, 0)]);
+            sx = sx - cp * V[up + 1];
+            sy = sy - cp * W[up + 1];
+            sz = sz - set(cZero[index(n, 0)]) * V[up];
+            for (int m = 1; m <= n; m++)
+            {
+                size_t i = index(n, m);
+                Pack c = set(cPlus[i]), s = set(sPlus[i]);
+                Pack cm = set(cMinus[i]), sm = set(sMinus[i]);
+                Pack cz = set(cZero[i]), sz2 = set(sZero[i]);
+                const Pack &vp = V[up + m + 1], &wp = W[up + m + 1];
+                const Pack &vm = V[up + m - 1], &wm = W[up + m - 1];
+                sx = sx - c * vp - s * wp + cm * vm + sm * wm;
+                sy = sy - c * wp + s * vp - cm * wm + sm * vm;
+                sz = sz - cz * V[up + m] - sz2 * W[up + m];
+            }
+        }
+
+        double rx[width], ry[width], rz[width];
+        store(rx, sx * scale);
+        store(ry, sy * scale);
+        store(rz, sz * scale);
+        for (size_t k = 0; k < width && i + k < count; k++)
+        {
+            ax[i + k] = rx[k];
+            ay[i + k] = ry[k];
+            az[i + k] = rz[k];
+        }
+    }
+}
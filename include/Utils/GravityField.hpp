@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "static/wgs84.hpp"
+
+/*
+    spherical harmonic gravity field of the earth (EGM96 / EGM2008 style)
+
+    fully normalized Cnm/Snm are read from an ICGEM .gfc or a plain
+    "n m C S" coefficient file, without one the field is point mass + J2.
+    the acceleration comes from the Cunningham V/W recursion (Montenbruck &
+    Gill 3.2) which stays regular at the poles. every normalization factor
+    of the recursion and of the acceleration sums only depends on n and m,
+    so they are folded with the coefficients once per degree change and the
+    per body work is multiply-adds, run a SIMD pack of bodies at a time
+*/
+class GravityField {
+public:
+        GravityField(const GravityField &obj) = delete;
+        static GravityField *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new GravityField();
+            return instance;
+        }
+
+    // reads a coefficient file and evaluates it up to degree (everything in the file when < 0)
+    // on failure prints the reason and keeps the current field
+    bool load(const std::string &path, int degree = -1);
+
+    // truncates the loaded field, clamped to what the file holds
+    void setDegree(int newDegree);
+    int getDegree() const { return degree; }
+    int getMaxDegree() const { return maxDegree; }
+    const std::string &getSource() const { return source; }
+
+    // acceleration in engine units/s² at count ECEF points, earth fixed (no rotation terms)
+    void acceleration(const double *x, const double *y, const double *z,
+                      double *ax, double *ay, double *az, size_t count) const;
+
+private:
+    static GravityField *instance;
+    GravityField();
+
+    // index of (n, m) in the triangular arrays
+    static size_t index(int n, int m) { return n * (n + 1) / 2 + m; }
+
+    // rebuilds the folded factors below for the current degree
+    void prepare();
+
+    double gm = WGS84::GM;    // engine units³/s²
+    double radius = WGS84::A; // reference radius of the coefficients, engine units
+    int maxDegree = 0;
+    int degree = 0;
+    std::string source;
+    // fully normalized coefficients as loaded, up to maxDegree
+    std::vector<double> C, S;
+
+    // recursion up to degree + 1 : V(m,m) from V(m-1,m-1), V(n,m) from V(n-1,m) and V(n-2,m)
+    std::vector<double> diagonal, alpha, beta;
+    // coefficients folded with the normalization of the acceleration sums, up to degree
+    std::vector<double> cPlus, sPlus, cMinus, sMinus, cZero, sZero;
+};
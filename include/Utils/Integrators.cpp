@@ -0,0 +1,255 @@
+#include "Utils/Integrators.hpp"
+#include "Utils/BodyStore.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    struct IntegratorInfo {
+        Integrator integrator;
+        const char *name;
+    };
+    const IntegratorInfo integrators[] = {
+        {Integrator::SemiImplicitEuler, "euler"},
+        {Integrator::VelocityVerlet, "verlet"},
+        {Integrator::Leapfrog, "leapfrog"},
+        {Integrator::RK4, "rk4"},
+        {Integrator::DormandPrince, "rk45"},
+    };
+
+    void load(const BodyStore &bodies, size_t i, double pos[3], double vel[3])
+    {
+        pos[0] = bodies.x[i];
+        pos[1] = bodies.y[i];
+        pos[2] = bodies.z[i];
+        vel[0] = bodies.vx[i];
+        vel[1] = bodies.vy[i];
+        vel[2] = bodies.vz[i];
+    }
+
+    void save(BodyStore &bodies, size_t i, const double pos[3], const double vel[3])
+    {
+        bodies.x[i] = pos[0];
+        bodies.y[i] = pos[1];
+        bodies.z[i] = pos[2];
+        bodies.vx[i] = vel[0];
+        bodies.vy[i] = vel[1];
+        bodies.vz[i] = vel[2];
+    }
+}
+
+bool Integrators::needsStartForce(Integrator integrator)
+{
+    return integrator != Integrator::Leapfrog;
+}
+
+void Integrators::velocityVerlet(BodyStore &bodies, size_t i, double deltaTime)
+{
+    double pos[3], vel[3], acc[3];
+    load(bodies, i, pos, vel);
+    double invMass = 1.0 / bodies.mass[i];
+    double half = 0.5 * deltaTime;
+
+    // kick with the start force, drift a full step
+    vel[0] += bodies.fx[i] * invMass * half;
+    vel[1] += bodies.fy[i] * invMass * half;
+    vel[2] += bodies.fz[i] * invMass * half;
+    for (int k = 0; k < 3; k++)
+        pos[k] += vel[k] * deltaTime;
+
+    // kick with the force at the new position, it is kept as the next step's start force
+    bodies.acceleration(i, pos, vel, acc, deltaTime);
+    for (int k = 0; k < 3; k++)
+        vel[k] += acc[k] * half;
+
+    save(bodies, i, pos, vel);
+    bodies.fx[i] = acc[0] * bodies.mass[i];
+    bodies.fy[i] = acc[1] * bodies.mass[i];
+    bodies.fz[i] = acc[2] * bodies.mass[i];
+    bodies.forceCurrent[i] = 1;
+}
+
+void Integrators::leapfrog(BodyStore &bodies, size_t i, double deltaTime)
+{
+    double pos[3], vel[3], acc[3];
+    load(bodies, i, pos, vel);
+    double half = 0.5 * deltaTime;
+
+    for (int k = 0; k < 3; k++)
+        pos[k] += vel[k] * half;
+    bodies.acceleration(i, pos, vel, acc, deltaTime);
+    for (int k = 0; k < 3; k++)
+    {
+        vel[k] += acc[k] * deltaTime;
+        pos[k] += vel[k] * half;
+    }
+
+    save(bodies, i, pos, vel);
+}
+
+void Integrators::rk4(BodyStore &bodies, size_t i, double deltaTime)
+{
+    double pos[3], vel[3];
+    load(bodies, i, pos, vel);
+    double invMass = 1.0 / bodies.mass[i];
+
+    // k*p are position derivatives (velocities), k*v velocity derivatives (accelerations)
+    double k1p[3] = {vel[0], vel[1], vel[2]};
+    double k1v[3] = {bodies.fx[i] * invMass, bodies.fy[i] * invMass, bodies.fz[i] * invMass};
+    double k2p[3], k2v[3], k3p[3], k3v[3], k4p[3], k4v[3];
+    double trialPos[3], trialVel[3];
+
+    for (int k = 0; k < 3; k++)
+    {
+        trialPos[k] = pos[k] + k1p[k] * deltaTime * 0.5;
+        trialVel[k] = vel[k] + k1v[k] * deltaTime * 0.5;
+    }
+    bodies.acceleration(i, trialPos, trialVel, k2v, deltaTime);
+    for (int k = 0; k < 3; k++)
+        k2p[k] = trialVel[k];
+
+    for (int k = 0; k < 3; k++)
+    {
+        trialPos[k] = pos[k] + k2p[k] * deltaTime * 0.5;
+        trialVel[k] = vel[k] + k2v[k] * deltaTime * 0.5;
+    }
+    bodies.acceleration(i, trialPos, trialVel, k3v, deltaTime);
+    for (int k = 0; k < 3; k++)
+        k3p[k] = trialVel[k];
+
+    for (int k = 0; k < 3; k++)
+    {
+        trialPos[k] = pos[k] + k3p[k] * deltaTime;
+        trialVel[k] = vel[k] + k3v[k] * deltaTime;
+    }
+    bodies.acceleration(i, trialPos, trialVel, k4v, deltaTime);
+    for (int k = 0; k < 3; k++)
+        k4p[k] = trialVel[k];
+
+    for (int k = 0; k < 3; k++)
+    {
+        pos[k] += deltaTime / 6.0 * (k1p[k] + 2 * k2p[k] + 2 * k3p[k] + k4p[k]);
+        vel[k] += deltaTime / 6.0 * (k1v[k] + 2 * k2v[k] + 2 * k3v[k] + k4v[k]);
+    }
+    save(bodies, i, pos, vel);
+}
+
+void Integrators::dormandPrince(BodyStore &bodies, size_t i, double deltaTime)
+{
+    // Dormand-Prince 5(4) tableau, row s holds the weights of stages 0..s-1
+    // the last row is the 5th order solution, so its derivative is the next sub step's first stage
+    static const double a[7][6] = {
+        {},
+        {1.0 / 5.0},
+        {3.0 / 40.0, 9.0 / 40.0},
+        {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0},
+        {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0},
+        {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0},
+        {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0},
+    };
+    // 5th minus 4th order weights, gives the local error estimate
+    static const double e[7] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                                -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+
+    // state is position then velocity, its derivative velocity then acceleration
+    double state[6], k[7][6], trial[6];
+    load(bodies, i, state, state + 3);
+    double invMass = 1.0 / bodies.mass[i];
+    for (int c = 0; c < 3; c++)
+    {
+        k[0][c] = state[3 + c];
+    }
+    k[0][3] = bodies.fx[i] * invMass;
+    k[0][4] = bodies.fy[i] * invMass;
+    k[0][5] = bodies.fz[i] * invMass;
+
+    double tolerance = bodies.getTolerance();
+    double step = bodies.stepSize[i] > 0.0 ? std::min(bodies.stepSize[i], deltaTime) : deltaTime;
+    double remaining = deltaTime;
+    int subSteps = 0;
+
+    while (remaining > 0.0)
+    {
+        bool lastChance = ++subSteps >= maxSubSteps;
+        double h = lastChance ? remaining : std::min(step, remaining);
+
+        for (int s = 1; s < 7; s++)
+        {
+            for (int c = 0; c < 6; c++)
+            {
+                double sum = 0.0;
+                for (int j = 0; j < s; j++)
+                    sum += a[s][j] * k[j][c];
+                trial[c] = state[c] + h * sum;
+            }
+            bodies.acceleration(i, trial, trial + 3, k[s] + 3, h);
+            for (int c = 0; c < 3; c++)
+                k[s][c] = trial[3 + c];
+        }
+
+        // rms of the error scaled by tolerance, both absolute and relative to the state
+        double error = 0.0;
+        for (int c = 0; c < 6; c++)
+        {
+            double delta = 0.0;
+            for (int j = 0; j < 7; j++)
+                delta += e[j] * k[j][c];
+            double scale = tolerance * (1.0 + std::max(std::fabs(state[c]), std::fabs(trial[c])));
+            error += (h * delta / scale) * (h * delta / scale);
+        }
+        error = std::sqrt(error / 6.0);
+
+        double factor = error > 0.0 ? 0.9 * std::pow(error, -0.2) : 5.0;
+        factor = std::clamp(factor, 0.2, 5.0);
+
+        if (error <= 1.0 || lastChance)
+        {
+            std::copy(trial, trial + 6, state);
+            std::copy(k[6], k[6] + 6, k[0]);
+            remaining -= h;
+            bodies.stepError[i] = error;
+            // a sub step clipped to the end of deltaTime says nothing against the longer one
+            step = h < step ? std::max(step, h * factor) : h * factor;
+        }
+        else
+            step = h * factor;
+        step = std::min(step, deltaTime);
+    }
+
+    save(bodies, i, state, state + 3);
+    bodies.stepSize[i] = step;
+    bodies.fx[i] = k[0][3] * bodies.mass[i];
+    bodies.fy[i] = k[0][4] * bodies.mass[i];
+    bodies.fz[i] = k[0][5] * bodies.mass[i];
+    bodies.forceCurrent[i] = 1;
+}
+
+const char *Integrators::name(Integrator integrator)
+{
+    for (const auto &info : integrators)
+        if (info.integrator == integrator)
+            return info.name;
+    return "unknown";
+}
+
+bool Integrators::parse(const std::string &name, Integrator &integrator)
+{
+    for (const auto &info : integrators)
+        if (name == info.name)
+        {
+            integrator = info.integrator;
+            return true;
+        }
+    return false;
+}
+
+std::string Integrators::names()
+{
+    std::string result;
+    for (const auto &info : integrators)
+    {
+        if (!result.empty())
+            result += "|";
+        result += info.name;
+    }
+    return result;
+}
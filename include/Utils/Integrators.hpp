@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class BodyStore;
+
+/*
+    time integration schemes a body can be stepped with
+
+    SemiImplicitEuler is what the engine always used (velocity first, then
+    position with the new velocity) and stays the default. the symplectic
+    ones keep orbital energy bounded, RK4 is 4th order but drifts slowly
+*/
+enum class Integrator : uint8_t {
+    SemiImplicitEuler, // 1 force evaluation, 1st order, symplectic
+    VelocityVerlet,    // kick-drift-kick, 1 evaluation (reuses the end of step force), 2nd order, symplectic
+    Leapfrog,          // drift-kick-drift, 1 evaluation at the half step, 2nd order, symplectic
+    RK4,               // classic Runge-Kutta, 4 evaluations, 4th order
+    DormandPrince      // embedded RK45, adapts its own sub steps to the error tolerance
+};
+
+namespace Integrators {
+    // true when the scheme starts from the force at the current state, which accumulateForces provides
+    bool needsStartForce(Integrator integrator);
+
+    // advance body i by deltaTime, fx/fy/fz already hold the start force when needsStartForce
+    // SemiImplicitEuler has no kernel here, it stays inline in BodyStore::integrate as the hot default
+    void velocityVerlet(BodyStore &bodies, size_t i, double deltaTime);
+    void leapfrog(BodyStore &bodies, size_t i, double deltaTime);
+    void rk4(BodyStore &bodies, size_t i, double deltaTime);
+    // covers deltaTime with as many sub steps as the body's local error needs, up to maxSubSteps
+    // the step size is remembered per body, a calm body does the whole deltaTime in one sub step
+    void dormandPrince(BodyStore &bodies, size_t i, double deltaTime);
+
+    // sub step budget of DormandPrince per body and step, the last one takes whatever time is left
+    constexpr int maxSubSteps = 64;
+
+    const char *name(Integrator integrator);
+    bool parse(const std::string &name, Integrator &integrator);
+    // all names, for console help
+    std::string names();
+};
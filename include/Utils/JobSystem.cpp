@@ -0,0 +1,175 @@
+#include "Utils/JobSystem.hpp"
+#include <algorithm>
+
+namespace Utils
+{
+
+JobSystem *JobSystem::instance = nullptr;
+thread_local size_t JobSystem::queueIndex = 0;
+
+JobSystem::JobSystem()
+{
+    size_t hardware = std::thread::hardware_concurrency();
+    start(hardware > 1 ? hardware - 1 : 0);
+}
+
+JobSystem::~JobSystem()
+{
+    stop();
+}
+
+void JobSystem::setThreadCount(size_t count)
+{
+    stop();
+    start(count > 1 ? count - 1 : 0);
+}
+
+void JobSystem::start(size_t workerCount)
+{
+    queues.clear();
+    for (size_t i = 0; i <= workerCount; i++)
+        queues.push_back(std::make_unique<Queue>());
+
+    running = true;
+    for (size_t i = 0; i < workerCount; i++)
+        workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+}
+
+void JobSystem::stop()
+{
+    // drain what is queued so no submitter waits forever
+    while (runOne())
+        ;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+JobCounter JobSystem::submit(Job job)
+{
+    JobCounter counter = std::make_shared<std::atomic<int>>(1);
+    push(Task{std::move(job), counter});
+    return counter;
+}
+
+void JobSystem::wait(const JobCounter &counter)
+{
+    while (counter->load() > 0)
+    {
+        if (!runOne())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t minGrain, const RangeJob &fn)
+{
+    if (count == 0)
+        return;
+
+    // a few chunks per thread so faster threads can steal the tail
+    size_t threads = getThreadCount();
+    size_t grain = std::max(minGrain, (count + threads * 4 - 1) / (threads * 4));
+    if (threads == 1 || grain >= count)
+    {
+        fn(0, count);
+        return;
+    }
+
+    size_t chunks = (count + grain - 1) / grain;
+    JobCounter counter = std::make_shared<std::atomic<int>>(chunks);
+    // the caller takes the first chunk itself
+    for (size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t begin = chunk * grain;
+        size_t end = std::min(count, begin + grain);
+        push(Task{[&fn, begin, end]() { fn(begin, end); }, counter});
+    }
+    fn(0, std::min(count, grain));
+    counter->fetch_sub(1);
+    wait(counter);
+}
+
+void JobSystem::push(Task task)
+{
+    size_t index = queueIndex;
+    // threads outside the pool spread their jobs over the workers
+    if (index == 0 && queues.size() > 1)
+        index = 1 + nextQueue.fetch_add(1) % (queues.size() - 1);
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+bool JobSystem::pop(size_t index, Task &task)
+{
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(size_t thief, Task &task)
+{
+    size_t count = queues.size();
+    for (size_t offset = 1; offset < count; offset++)
+    {
+        Queue &queue = *queues[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        jobsStolen++;
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne()
+{
+    Task task;
+    if (!pop(queueIndex, task) && !steal(queueIndex, task))
+        return false;
+    execute(task);
+    return true;
+}
+
+void JobSystem::execute(Task &task)
+{
+    pending--;
+    task.job();
+    jobsExecuted++;
+    task.counter->fetch_sub(1);
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    queueIndex = index;
+    while (true)
+    {
+        if (runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return !running || pending > 0; });
+        if (!running)
+            return;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils
+{
+    // counts the unfinished jobs of one submission, done when it reaches zero
+    using JobCounter = std::shared_ptr<std::atomic<int>>;
+
+    /*
+        engine wide work-stealing thread pool
+
+        every worker owns a queue, it pops its own jobs from the back and
+        steals from the front of the others when it runs dry. threads that
+        are not workers (the GLFW thread) push into a shared queue and help
+        out while they wait, so wait() never just blocks on a busy pool.
+
+        physics fans out over body ranges with parallelFor, background work
+        (broadphase, asset decoding, console jobs) goes through submit
+    */
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+        using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+        JobSystem(const JobSystem &obj) = delete;
+        static JobSystem *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new JobSystem();
+            return instance;
+        }
+        ~JobSystem();
+
+        // number of threads that execute jobs, the calling thread counts as one
+        size_t getThreadCount() const { return workers.size() + 1; }
+        void setThreadCount(size_t count);
+
+        JobCounter submit(Job job);
+        void wait(const JobCounter &counter);
+        bool isDone(const JobCounter &counter) const { return counter->load() == 0; }
+
+        // splits [0,count) into chunks of at least minGrain and runs fn on them in parallel, returns when all are done
+        void parallelFor(size_t count, size_t minGrain, const RangeJob &fn);
+
+        size_t getJobsExecuted() const { return jobsExecuted.load(); }
+        size_t getJobsStolen() const { return jobsStolen.load(); }
+
+    private:
+        static JobSystem *instance;
+        JobSystem();
+
+        struct Task
+        {
+            Job job;
+            JobCounter counter;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // queue 0 is shared by non-worker threads, worker i owns queue i+1
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<bool> running{false};
+        std::atomic<size_t> pending{0};
+        std::atomic<size_t> nextQueue{0};
+        std::atomic<size_t> jobsExecuted{0};
+        std::atomic<size_t> jobsStolen{0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+
+        static thread_local size_t queueIndex;
+
+        void start(size_t workerCount);
+        void stop();
+        void workerLoop(size_t index);
+        void push(Task task);
+        bool pop(size_t index, Task &task);
+        bool steal(size_t thief, Task &task);
+        bool runOne();
+        void execute(Task &task);
+    };
+}
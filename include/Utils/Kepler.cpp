@@ -0,0 +1,126 @@
+#include "Utils/Kepler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    double dot(const double a[3], const double b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // Stumpff functions C(z) and S(z), series near 0 where the closed forms cancel out
+    void stumpff(double z, double &c, double &s)
+    {
+        if (z > 1e-6)
+        {
+            double sz = std::sqrt(z);
+            c = (1.0 - std::cos(sz)) / z;
+            s = (sz - std::sin(sz)) / (sz * z);
+        }
+        else if (z < -1e-6)
+        {
+            double sz = std::sqrt(-z);
+            c = (std::cosh(sz) - 1.0) / -z;
+            s = (std::sinh(sz) - sz) / (sz * -z);
+        }
+        else
+        {
+            c = 0.5 - z / 24.0 + z * z / 720.0;
+            s = 1.0 / 6.0 - z / 120.0 + z * z / 5040.0;
+        }
+    }
+}
+
+void Kepler::propagate(const double r0[3], const double v0[3], double mu, double deltaTime, double r[3], double v[3])
+{
+    double r0n = std::sqrt(dot(r0, r0));
+    double sqrtMu = std::sqrt(mu);
+    double sigma = dot(r0, v0) / sqrtMu;
+    // reciprocal of the semi-major axis, negative on a hyperbola
+    double alpha = 2.0 / r0n - dot(v0, v0) / mu;
+
+    // whole revolutions change nothing, dropping them keeps the iteration short
+    if (alpha > 0.0)
+    {
+        double period = 2.0 * M_PI / (sqrtMu * std::sqrt(alpha * alpha * alpha));
+        deltaTime = std::remainder(deltaTime, period);
+    }
+
+    double chi = sqrtMu * deltaTime / r0n;
+    if (alpha > 0.0)
+        chi = sqrtMu * alpha * deltaTime;
+    double c = 0.5, s = 1.0 / 6.0;
+
+    // Laguerre-Conway converges from anywhere on this equation, Newton can cycle on eccentric orbits
+    const int order = 5;
+    for (int iteration = 0; iteration < 50; iteration++)
+    {
+        double z = alpha * chi * chi;
+        stumpff(z, c, s);
+        double f = sigma * chi * chi * c + (1.0 - alpha * r0n) * chi * chi * chi * s + r0n * chi - sqrtMu * deltaTime;
+        double df = sigma * chi * (1.0 - z * s) + (1.0 - alpha * r0n) * chi * chi * c + r0n;
+        double ddf = sigma * (1.0 - z * c) + (1.0 - alpha * r0n) * chi * (1.0 - z * s);
+        double root = std::sqrt(std::fabs((order - 1) * (order - 1) * df * df - order * (order - 1) * f * ddf));
+        double delta = order * f / (df + std::copysign(root, df));
+        chi -= delta;
+        if (std::fabs(delta) <= 1e-13 * std::max(1.0, std::fabs(chi)))
+            break;
+    }
+
+    double z = alpha * chi * chi;
+    stumpff(z, c, s);
+    double f = 1.0 - chi * chi / r0n * c;
+    double g = deltaTime - chi * chi * chi * s / sqrtMu;
+    for (int k = 0; k < 3; k++)
+        r[k] = f * r0[k] + g * v0[k];
+    double rn = std::sqrt(dot(r, r));
+    double df = sqrtMu / (rn * r0n) * (alpha * chi * chi * chi * s - chi);
+    double dg = 1.0 - chi * chi / rn * c;
+    for (int k = 0; k < 3; k++)
+        v[k] = df * r0[k] + dg * v0[k];
+}
+
+double Kepler::timeToRadius(const double r[3], const double v[3], double mu, double radius)
+{
+    const double never = std::numeric_limits<double>::infinity();
+    double rn = std::sqrt(dot(r, r));
+    if (rn <= radius)
+        return 0.0;
+
+    double h[3] = {r[1] * v[2] - r[2] * v[1], r[2] * v[0] - r[0] * v[2], r[0] * v[1] - r[1] * v[0]};
+    double hn = std::sqrt(dot(h, h));
+    double p = hn * hn / mu;
+    double alpha = 2.0 / rn - dot(v, v) / mu;
+    double e = std::sqrt(std::max(0.0, 1.0 - p * alpha));
+    if (p / (1.0 + e) >= radius)
+        return never;
+
+    // true anomaly now and where the conic crosses the radius on the way down
+    double vr = dot(r, v) / rn;
+    double nu = std::atan2(hn / mu * vr, p / rn - 1.0);
+    double crossing = -std::acos(std::clamp((p / radius - 1.0) / e, -1.0, 1.0));
+
+    if (alpha > 0.0)
+    {
+        auto meanAnomaly = [e](double trueAnomaly) {
+            double E = 2.0 * std::atan(std::sqrt((1.0 - e) / (1.0 + e)) * std::tan(trueAnomaly / 2));
+            return E - e * std::sin(E);
+        };
+        double n = std::sqrt(mu * alpha * alpha * alpha);
+        double dM = std::fmod(meanAnomaly(crossing) - meanAnomaly(nu), 2.0 * M_PI);
+        if (dM < 0.0)
+            dM += 2.0 * M_PI;
+        return dM / n;
+    }
+
+    // a hyperbola only comes down before periapsis
+    if (vr >= 0.0)
+        return never;
+    auto meanAnomaly = [e](double trueAnomaly) {
+        double F = 2.0 * std::atanh(std::sqrt((e - 1.0) / (e + 1.0)) * std::tan(trueAnomaly / 2));
+        return e * std::sinh(F) - F;
+    };
+    double n = std::sqrt(mu * -alpha * alpha * alpha);
+    return std::max(0.0, (meanAnomaly(crossing) - meanAnomaly(nu)) / n);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+    analytic two-body motion for bodies coasting above the atmosphere
+
+    propagate() uses the universal variable form of Kepler's equation
+    (Vallado 2.3, Laguerre-Conway iteration) so ellipses and hyperbolas go
+    through the same code and the cost does not depend on the time span.
+    everything is in the frame and units of the BodyStore : ECEF without
+    rotation terms, like the numerical forces, engine units and seconds
+*/
+namespace Kepler {
+    // conic a body follows from epoch on, its state at epoch and when it may reach the atmosphere again
+    struct Orbit {
+        double epoch = 0.0;
+        double wake = 0.0;
+        double r[3] = {0.0, 0.0, 0.0};
+        double v[3] = {0.0, 0.0, 0.0};
+    };
+
+    // state after deltaTime seconds (negative goes back) on the conic through r0, v0
+    void propagate(const double r0[3], const double v0[3], double mu, double deltaTime, double r[3], double v[3]);
+
+    // seconds until the conic through r, v first comes down to the given radius, infinity if it never does
+    double timeToRadius(const double r[3], const double v[3], double mu, double radius);
+};
@@ -0,0 +1,182 @@
+#include "Utils/PerfCounters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters *PerfCounters::instance = nullptr;
+
+namespace {
+#ifdef __linux__
+    const uint64_t events[PerfCounters::CounterCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    // the calling thread's counters, the first one leads the group so they are read together
+    struct ThreadGroup {
+        bool tried = false;
+        int fds[PerfCounters::CounterCount] = {-1, -1, -1, -1};
+
+        ~ThreadGroup() { close(); }
+
+        bool open()
+        {
+            tried = true;
+            for (int k = 0; k < PerfCounters::CounterCount; k++)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = events[k];
+                attr.disabled = k == 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                // this thread on any cpu
+                fds[k] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, k == 0 ? -1 : fds[0], 0));
+                if (fds[k] < 0)
+                {
+                    close();
+                    return false;
+                }
+            }
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            return true;
+        }
+
+        void close()
+        {
+            for (int &fd : fds)
+            {
+                if (fd >= 0)
+                    ::close(fd);
+                fd = -1;
+            }
+        }
+    };
+    thread_local ThreadGroup group;
+#endif
+}
+
+PerfCounters::Scope::Scope(Section section, size_t items) : section(section), items(items)
+{
+    PerfCounters *perf = PerfCounters::getInstance();
+    if (perf->isEnabled())
+        counting = perf->read(begin);
+}
+
+PerfCounters::Scope::~Scope()
+{
+    if (!counting)
+        return;
+    PerfCounters *perf = PerfCounters::getInstance();
+    uint64_t end[CounterCount];
+    if (perf->read(end))
+        perf->add(section, begin, end, items);
+}
+
+bool PerfCounters::read(uint64_t values[CounterCount])
+{
+#ifdef __linux__
+    if (!group.tried && !group.open() && !failed.exchange(true))
+        std::cerr << "ERROR::PERF: perf_event_open failed, " << std::strerror(errno)
+                  << " (see /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+    if (group.fds[0] < 0)
+        return false;
+
+    struct {
+        uint64_t count;
+        uint64_t values[CounterCount];
+    } data;
+    if (::read(group.fds[0], &data, sizeof(data)) != sizeof(data) || data.count != CounterCount)
+        return false;
+    std::memcpy(values, data.values, sizeof(data.values));
+    return true;
+#else
+    failed = true;
+    return false;
+#endif
+}
+
+void PerfCounters::add(Section section, const uint64_t begin[CounterCount], const uint64_t end[CounterCount], size_t count)
+{
+    for (int k = 0; k < CounterCount; k++)
+        counts[section][k].fetch_add(end[k] - begin[k], std::memory_order_relaxed);
+    items[section].fetch_add(count, std::memory_order_relaxed);
+    calls[section].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfCounters::reset()
+{
+    for (int s = 0; s < SectionCount; s++)
+    {
+        for (int k = 0; k < CounterCount; k++)
+            counts[s][k] = 0;
+        items[s] = 0;
+        calls[s] = 0;
+    }
+}
+
+PerfCounters::Totals PerfCounters::getTotals(Section section) const
+{
+    Totals totals;
+    for (int k = 0; k < CounterCount; k++)
+        totals.counts[k] = counts[section][k].load();
+    totals.items = items[section].load();
+    totals.calls = calls[section].load();
+    return totals;
+}
+
+const char *PerfCounters::sectionName(Section section)
+{
+    switch (section)
+    {
+    case Physics:
+        return "physics";
+    case Geodesy:
+        return "geodesy";
+    case Draw:
+        return "draw";
+    default:
+        return "?";
+    }
+}
+
+std::string PerfCounters::report() const
+{
+    // what one item of each section is, singular and plural
+    const char *itemNames[SectionCount] = {"body", "point", "draw"};
+    const char *itemPlurals[SectionCount] = {"bodies", "points", "draws"};
+
+    std::ostringstream oss;
+    if (!isAvailable())
+        oss << "counters unavailable, perf_event_open was refused\n";
+    oss << std::fixed << std::setprecision(2);
+    for (int s = 0; s < SectionCount; s++)
+    {
+        Totals totals = getTotals(static_cast<Section>(s));
+        oss << sectionName(static_cast<Section>(s)) << " : ";
+        if (totals.calls == 0 || totals.items == 0 || totals.counts[Cycles] == 0)
+        {
+            oss << "no samples\n";
+            continue;
+        }
+        double perItem = 1.0 / totals.items;
+        oss << "ipc " << static_cast<double>(totals.counts[Instructions]) / totals.counts[Cycles]
+            << ", cycles/" << itemNames[s] << " " << totals.counts[Cycles] * perItem
+            << ", llc miss/" << itemNames[s] << " " << std::setprecision(4) << totals.counts[LlcMisses] * perItem
+            << ", branch miss/" << itemNames[s] << " " << totals.counts[BranchMisses] * perItem
+            << std::setprecision(2) << ", " << totals.items << " " << itemPlurals[s] << " in " << totals.calls << " scopes\n";
+    }
+    std::string text = oss.str();
+    text.pop_back();
+    return text;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    hardware counters around the engine's hot loops, Linux perf_event_open
+
+    every thread opens its own group (cycles, instructions, LLC misses,
+    branch misses) the first time it enters a Scope while counting is on,
+    the group only counts that thread in user space. a Scope reads the
+    group when it starts and ends and adds the difference and its item
+    count (bodies, points, draws) to its section, so the physics slices
+    add up over the worker threads. scopes may nest, a section counts
+    everything under it. reading costs a syscall, scopes sit around
+    slices and loops, never single bodies. off by default, then a Scope
+    is one relaxed load. elsewhere than Linux, or when the kernel refuses
+    (perf_event_paranoid, containers), nothing is counted
+*/
+class PerfCounters {
+public:
+        PerfCounters(const PerfCounters &obj) = delete;
+        static PerfCounters *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new PerfCounters();
+            return instance;
+        }
+
+    enum Section { Physics, Geodesy, Draw, SectionCount };
+    enum Counter { Cycles, Instructions, LlcMisses, BranchMisses, CounterCount };
+
+    class Scope {
+    public:
+        Scope(Section section, size_t items);
+        ~Scope();
+    private:
+        Section section;
+        size_t items;
+        bool counting = false;
+        uint64_t begin[CounterCount];
+    };
+
+    struct Totals {
+        uint64_t counts[CounterCount];
+        uint64_t items;
+        uint64_t calls;
+    };
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+    // false once a thread could not open its counters
+    bool isAvailable() const { return !failed.load(); }
+    void reset();
+
+    Totals getTotals(Section section) const;
+    static const char *sectionName(Section section);
+    // IPC and per item counts of every section, one line each
+    std::string report() const;
+
+private:
+    static PerfCounters *instance;
+    PerfCounters() = default;
+
+    // reads the calling thread's group, opening it first, false if it has none
+    bool read(uint64_t values[CounterCount]);
+    void add(Section section, const uint64_t begin[CounterCount], const uint64_t end[CounterCount], size_t items);
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> counts[SectionCount][CounterCount] = {};
+    std::atomic<uint64_t> items[SectionCount] = {};
+    std::atomic<uint64_t> calls[SectionCount] = {};
+};
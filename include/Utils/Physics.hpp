@@ -2,6 +2,8 @@
 #include <cmath>
 #include <glm/glm.hpp>
 #include "static/wgs84.hpp"
+#include "static/atmosphere.hpp"
+#include "Utils/GravityField.hpp"
 #include <iostream>
 
 class Position {
@@ -17,6 +19,11 @@ public:
         updateGeodetic();
     }
 
+    // Constructor from an already known state, skips the coordinate conversions
+    Position(double x, double y, double z, double vx, double vy, double vz, double lat, double lon, double alt)
+        : latitude(lat), longitude(lon), altitude(alt), ecefX(x), ecefY(y), ecefZ(z),
+          velocityX(vx), velocityY(vy), velocityZ(vz) {}
+
     // Getters
     double getLatitude() const { return latitude; }
     double getLongitude() const { return longitude; }
@@ -80,6 +87,10 @@ public:
         totalForceZ += forceZ;
     }
 
+    void getTotalForce(double& forceX, double& forceY, double& forceZ) const {
+        forceX = totalForceX; forceY = totalForceY; forceZ = totalForceZ;
+    }
+
     // Calculate and Apply Forces
     void calculateAndApplyForces(double mass, double deltaTime) {
         applyForce(totalForceX, totalForceY, totalForceZ, mass, deltaTime);
@@ -146,26 +157,20 @@ private:
     }
 };
 
-class Force {
-public:
-    // Constructor
-    Force(double mass) : mass(mass) {}
-    
-    // Virtual destructor
-    virtual ~Force() = default;
+/*
+    force terms are plain values with a non-virtual apply, a body's forces are
+    composed at compile time by ForceSet (see Utils/ForceModels.hpp) so the
+    whole stack inlines into one kernel per body type
+*/
 
-    // Virtual apply method
-    virtual void apply(Position& position, double deltaTime) = 0;
+// US1976 density in kg/m³ at the body's altitude, which Position keeps in engine units
+inline double airDensity(const Position& position) {
+    return Atmosphere::density(position.getAltitude() / WGS84::UnitToMeterRatio);
+}
 
-protected:
-    double mass;
-};
-
-class GravityForce : public Force {
+class GravityForce {
 public:
-    GravityForce(double mass) : Force(mass) {}
-
-    void apply(Position& position, double deltaTime) override {
+    void apply(Position& position, double mass, double) const {
         double x, y, z;
         position.getECEF(x, y, z);
         double lat, lon, alt;
@@ -187,31 +192,40 @@ public:
     }
 };
 
-class DragForce : public Force {
+// spherical harmonic gravity of GravityField, for orbital work
+// batched : the BodyStore evaluates it for a whole slice of bodies in one SIMD pass
+// keplerian : far from the ground its central term is the conic the BodyStore can coast a body on
+class HarmonicGravityForce {
 public:
-    DragForce(double mass, double dragCoefficient)
-        : Force(mass), dragCoefficient(dragCoefficient) {}
-
-    void apply(Position& position, double airDensity, double deltaTime) {
-        double vx, vy, vz;
-        position.getVelocity(vx, vy, vz);
+    static constexpr bool batched = true;
+    static constexpr bool keplerian = true;
 
-        double speed = std::sqrt(vx * vx + vy * vy + vz * vz);
-        double dragForceMagnitude = 0.5 * dragCoefficient * airDensity * speed * speed;
+    void apply(Position& position, double mass, double) const {
+        double x, y, z;
+        position.getECEF(x, y, z);
+        double ax, ay, az;
+        GravityField::getInstance()->acceleration(&x, &y, &z, &ax, &ay, &az, 1);
+        position.addForce(ax * mass, ay * mass, az * mass);
+    }
+};
 
-        double forceX = -dragForceMagnitude * (vx / speed);
-        double forceY = -dragForceMagnitude * (vy / speed);
-        double forceZ = -dragForceMagnitude * (vz / speed);
+// zero where Atmosphere::density is, so it does not stop a body from coasting on a conic up there
+class DragForce {
+public:
+    static constexpr bool vanishesInVacuum = true;
 
-        position.addForce(forceX, forceY, forceZ);
-    }
+    explicit DragForce(double dragCoefficient)
+        : dragCoefficient(dragCoefficient) {}
 
-    void apply(Position& position, double deltaTime) override {
+    void apply(Position& position, double, double) const {
         double vx, vy, vz;
         position.getVelocity(vx, vy, vz);
 
         double speed = std::sqrt(vx * vx + vy * vy + vz * vz);
-        double dragForceMagnitude = 0.5 * dragCoefficient * 1.225 * speed * speed;
+        double rho = airDensity(position);
+        if (speed == 0.0 || rho == 0.0)
+            return;
+        double dragForceMagnitude = 0.5 * dragCoefficient * rho * speed * speed;
 
         double forceX = -dragForceMagnitude * (vx / speed);
         double forceY = -dragForceMagnitude * (vy / speed);
@@ -224,47 +238,35 @@ private:
     double dragCoefficient;
 };
 
-class LiftForce : public Force {
+class LiftForce {
 public:
-    LiftForce(double mass, double liftCoefficient,double wingArea)
-        : Force(mass), liftCoefficient(liftCoefficient),wingArea(wingArea) {}
+    static constexpr bool vanishesInVacuum = true;
 
-    void apply(Position& position, double airDensity, double wingArea, double deltaTime) {
-        double vx, vy, vz;
-        position.getVelocity(vx, vy, vz);
-        double lat, lon, alt;
-        position.getGeodetic(lat, lon, alt);
+    LiftForce(double liftCoefficient, double wingArea)
+        : liftCoefficient(liftCoefficient), wingArea(wingArea) {}
 
-        double speed = std::sqrt(vx * vx + vy * vy + vz * vz);
-        double liftForceMagnitude = 0.5 * liftCoefficient * airDensity * speed * speed * wingArea;
-
-        glm::vec3 normal = WGS84::surfaceNormal(lat, lon);
-
-        // Assuming lift acts perpendicularly to the velocity in the vertical direction
-        double forceX = liftCoefficient * (vx / speed);
-        double forceY = liftCoefficient * (vy / speed);
-        double forceZ = liftCoefficient * (vz / speed);
-
-        position.addForce(forceX, forceY, forceZ);
-    }
-
-        void apply(Position& position, double deltaTime) override {
+    void apply(Position& position, double, double) const {
         double vx, vy, vz;
         position.getVelocity(vx, vy, vz);
         double lat, lon, alt;
         position.getGeodetic(lat, lon, alt);
 
         double speed = std::sqrt(vx * vx + vy * vy + vz * vz);
-        double liftForceMagnitude = 0.5 * liftCoefficient * 1.225 * speed * speed * wingArea;
-
-        glm::vec3 normal = WGS84::surfaceNormal(lat, lon);
-
-        // Assuming lift acts perpendicularly to the velocity in the vertical direction
-        double forceX = liftCoefficient * (vx / speed);
-        double forceY = liftCoefficient * (vy / speed);
-        double forceZ = liftCoefficient * (vz / speed);
-
-        position.addForce(forceX, forceY, forceZ);
+        double rho = airDensity(position);
+        if (speed == 0.0 || rho == 0.0)
+            return;
+        double liftForceMagnitude = 0.5 * liftCoefficient * rho * speed * speed * wingArea;
+
+        // Lift acts perpendicularly to the velocity, in the vertical plane : the part of the up normal across the velocity
+        glm::dvec3 normal(WGS84::surfaceNormal(lat, lon));
+        glm::dvec3 direction = glm::dvec3(vx, vy, vz) / speed;
+        glm::dvec3 across = normal - glm::dot(normal, direction) * direction;
+        double length = glm::length(across);
+        if (length == 0.0)
+            return;
+        across *= liftForceMagnitude / length;
+
+        position.addForce(across.x, across.y, across.z);
     }
 
 private:
@@ -272,11 +274,17 @@ private:
     double wingArea;
 };
 
-class ThrustForce : public Force {
+class ThrustForce {
 public:
-    ThrustForce(double mass) : Force(mass) {}
+    ThrustForce(double thrustX, double thrustY, double thrustZ)
+        : thrustX(thrustX), thrustY(thrustY), thrustZ(thrustZ) {}
 
-    void apply(Position& position, double thrustX, double thrustY, double thrustZ, double deltaTime) {
+    void apply(Position& position, double, double) const {
         position.addForce(thrustX, thrustY, thrustZ);
     }
-};
\ No newline at end of file
+
+private:
+    double thrustX;
+    double thrustY;
+    double thrustZ;
+};
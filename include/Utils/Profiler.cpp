@@ -0,0 +1,183 @@
+#include "Utils/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+Profiler *Profiler::instance = nullptr;
+
+Profiler::Scope::Scope(const char *name)
+    :
+#ifdef EARTH_SIM_TRACE
+      trace(name),
+#endif
+      section(Profiler::getInstance()->sectionOf(name, false)), start(std::chrono::steady_clock::now())
+{
+}
+
+Profiler::Scope::~Scope()
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    Profiler::getInstance()->add(section, elapsed.count());
+}
+
+Profiler::GpuScope::GpuScope(const char *name)
+{
+    Profiler *profiler = Profiler::getInstance();
+    profiler->beginQuery(profiler->sectionOf(name, true));
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+    Profiler::getInstance()->endQuery();
+}
+
+size_t Profiler::sectionOf(const char *name, bool gpu)
+{
+    // gpu sections get their own names, a phase can be timed on both sides
+    std::string key = gpu ? std::string("gpu ") + name : std::string(name);
+    auto it = sectionIndex.find(key);
+    if (it != sectionIndex.end())
+        return it->second;
+
+    Section section;
+    section.name = key;
+    section.gpu = gpu;
+    section.samples.assign(History, 0.0f);
+    if (gpu)
+        glGenQueries(QueryDepth, section.queries);
+    sections.push_back(section);
+    sectionIndex[key] = sections.size() - 1;
+    return sections.size() - 1;
+}
+
+void Profiler::beginQuery(size_t index)
+{
+    Section &section = sections[index];
+    size_t slot = section.next;
+    section.next = (section.next + 1) % QueryDepth;
+    // still not back after a whole ring of frames, its frame goes without a sample
+    if (section.pending[slot])
+        section.samples[section.issuedIn[slot] % History] = NAN;
+    glBeginQuery(GL_TIME_ELAPSED, section.queries[slot]);
+    section.pending[slot] = true;
+    section.issuedIn[slot] = frames;
+}
+
+void Profiler::endQuery()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+void Profiler::beginFrame()
+{
+    for (Section &section : sections)
+        section.current = 0.0;
+    frameStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endFrame()
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - frameStart;
+    add(sectionOf("total", false), elapsed.count());
+    size_t slot = frames % History;
+    for (Section &section : sections)
+        section.samples[slot] = section.gpu ? NAN : static_cast<float>(section.current);
+    for (Section &section : sections)
+        if (section.gpu)
+            collectQueries(section);
+    frames++;
+}
+
+void Profiler::collectQueries(Section &section)
+{
+    // oldest first, GL finishes queries in the order they were issued
+    for (size_t k = 0; k < QueryDepth; k++)
+    {
+        size_t slot = (section.next + k) % QueryDepth;
+        if (!section.pending[slot])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(section.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(section.queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        section.pending[slot] = false;
+        float &sample = section.samples[section.issuedIn[slot] % History];
+        sample = (std::isnan(sample) ? 0.0f : sample) + static_cast<float>(nanoseconds / 1e6);
+    }
+}
+
+void Profiler::reset()
+{
+    for (Section &section : sections)
+    {
+        std::fill(section.samples.begin(), section.samples.end(), 0.0f);
+        section.current = 0.0;
+        // results still in flight belong to frames before the reset
+        std::fill(section.pending, section.pending + QueryDepth, false);
+    }
+    frames = 0;
+}
+
+std::vector<Profiler::Stats> Profiler::getStats() const
+{
+    std::vector<Stats> stats;
+    size_t kept = std::min(frames, History);
+    std::vector<float> sorted;
+    for (const Section &section : sections)
+    {
+        Stats s{section.name, section.gpu, 0.0, 0.0};
+        // GPU frames whose result never came back have no sample
+        sorted.clear();
+        double sum = 0.0;
+        for (size_t i = 0; i < kept; i++)
+        {
+            if (std::isnan(section.samples[i]))
+                continue;
+            sorted.push_back(section.samples[i]);
+            sum += section.samples[i];
+        }
+        if (!sorted.empty())
+        {
+            s.average = sum / sorted.size();
+            size_t rank = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+            s.p99 = sorted[rank];
+        }
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+bool Profiler::dump(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "ERROR::PROFILER: could not write " << path << std::endl;
+        return false;
+    }
+
+    file << "frame";
+    for (const Section &section : sections)
+        file << "," << section.name;
+    file << "\n";
+
+    // oldest kept frame first
+    size_t kept = std::min(frames, History);
+    for (size_t frame = frames - kept; frame < frames; frame++)
+    {
+        file << frame;
+        for (const Section &section : sections)
+        {
+            file << ",";
+            float ms = section.samples[frame % History];
+            if (!std::isnan(ms))
+                file << ms;
+        }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
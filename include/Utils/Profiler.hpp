@@ -0,0 +1,101 @@
+#pragma once
+#include <GL/glew.h>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "Utils/Trace.hpp"
+
+/*
+    per frame timings of the engine's phases
+
+    CPU sections are timed by a Scope on the stack, GPU sections by a
+    GpuScope around GL_TIME_ELAPSED queries. GPU scopes must not nest (GL
+    allows one elapsed query at a time) and each has a ring of QueryDepth
+    queries : every frame end collects the results that are there and
+    files them under the frame that issued them, so the CPU never waits
+    for the GPU. a query the GPU is still behind on when the ring comes
+    round to it again is dropped, that frame has no GPU sample instead of
+    a 0. a section timed several times in a frame adds up. the last
+    History frames are kept for the rolling averages, p99 and dump()
+*/
+class Profiler {
+public:
+        Profiler(const Profiler &obj) = delete;
+        static Profiler *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new Profiler();
+            return instance;
+        }
+
+    // also a trace marker when tracing is built in
+    class Scope {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+    private:
+#ifdef EARTH_SIM_TRACE
+        Trace::Scope trace;
+#endif
+        size_t section;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    class GpuScope {
+    public:
+        explicit GpuScope(const char *name);
+        ~GpuScope();
+    };
+
+    // a frame's samples are recorded when it ends, along with the whole frame as "total"
+    void beginFrame();
+    void endFrame();
+    void reset();
+
+    struct Stats {
+        std::string name;
+        bool gpu;
+        double average; // ms over the kept frames that have a sample
+        double p99;
+    };
+    std::vector<Stats> getStats() const;
+    size_t getFrameCount() const { return frames; }
+
+    // one row per kept frame, one column per section in ms (empty without a sample), false if the file can not be written
+    bool dump(const std::string &path) const;
+
+    static constexpr size_t History = 600;
+    static constexpr size_t QueryDepth = 4;
+
+private:
+    static Profiler *instance;
+    Profiler() = default;
+
+    struct Section {
+        std::string name;
+        bool gpu = false;
+        double current = 0.0;       // ms of the frame being timed
+        std::vector<float> samples; // ring of History frames, NaN = no sample
+        GLuint queries[QueryDepth] = {};
+        bool pending[QueryDepth] = {};
+        size_t issuedIn[QueryDepth] = {}; // frame each pending query was issued in
+        size_t next = 0;                  // query the next GpuScope uses
+    };
+
+    size_t sectionOf(const char *name, bool gpu);
+    void add(size_t section, double ms) { sections[section].current += ms; }
+    void beginQuery(size_t section);
+    void endQuery();
+    // files the GPU results that are ready under their frames
+    void collectQueries(Section &section);
+
+    std::vector<Section> sections;
+    std::map<std::string, size_t> sectionIndex;
+    size_t frames = 0;  // frames recorded since the last reset
+    std::chrono::steady_clock::time_point frameStart;
+};
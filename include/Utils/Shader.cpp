@@ -1,17 +1,61 @@
 #include "Shader.hpp"
+#include <algorithm>
+#include <vector>
 
 
 
 
-GLint Shader::getUniformLocation(const std::string& name) {
-    // Check if the uniform location is already cached
+GLint Shader::getUniformLocation(const std::string& name) const {
     auto it = uniformLocations.find(name);
     if (it != uniformLocations.end()) {
         return it->second;
     }
+    return -1;
+}
 
-    // Get and cache the uniform location
-    GLint location = glGetUniformLocation(programID, name.c_str());
-    uniformLocations[name] = location;
-    return location;
-}
\ No newline at end of file
+void Shader::cacheUniforms() {
+    uniformLocations.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(programID, i, name.size(), &length, &size, &type, name.data());
+        std::string uniform(name.data(), length);
+        // uniforms of a block have no location
+        GLint location = glGetUniformLocation(programID, uniform.c_str());
+        if (location < 0)
+            continue;
+        // arrays are reported as name[0], callers use the bare name
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            uniform.resize(uniform.size() - 3);
+        uniformLocations[uniform] = location;
+    }
+
+    GLuint camera = glGetUniformBlockIndex(programID, "Camera");
+    if (camera != GL_INVALID_INDEX)
+        glUniformBlockBinding(programID, camera, CameraBinding);
+}
+
+void Shader::updateCameraBlock(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos) {
+    // std140 : two mat4 then the position padded to a vec4
+    struct CameraBlock {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 viewPos;
+    };
+    static GLuint buffer = 0;
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, CameraBinding, buffer);
+    }
+    CameraBlock block{view, projection, glm::vec4(viewPos, 1.0f)};
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -15,7 +15,16 @@ class Shader
 {
 public:
 
-    GLint getUniformLocation(const std::string &locationName);
+    // location resolved when the program was linked, -1 for uniforms the program does not use
+    GLint getUniformLocation(const std::string &locationName) const;
+
+    /*
+        view, projection and camera position live in one std140 uniform block
+        (Camera, see shaders/simple.vs) bound to CameraBinding for every program
+        that declares it, so they are uploaded once per frame instead of per object
+    */
+    static constexpr GLuint CameraBinding = 0;
+    static void updateCameraBlock(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos);
 
     Shader():
     Shader("simple","simple")
@@ -69,6 +78,8 @@ public:
             std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
                       << infoLog << "on file : " << vertexPath << "\n and : " << fragmentPath << std::endl;
         }
+        else
+            cacheUniforms();
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         loaded=true;
@@ -79,59 +90,64 @@ public:
     // ------------------------------------------------------------------------
     void setBool(const std::string &locationName, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(programID, locationName.c_str()), (int)value); 
+        glUniform1i(getUniformLocation(locationName), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &locationName, int value) const
     { 
-        glUniform1i(glGetUniformLocation(programID, locationName.c_str()), value); 
+        glUniform1i(getUniformLocation(locationName), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &locationName, float value) const
     { 
-        glUniform1f(glGetUniformLocation(programID, locationName.c_str()), value); 
+        glUniform1f(getUniformLocation(locationName), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &locationName, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(programID, locationName.c_str()), 1, &value[0]); 
+        glUniform2fv(getUniformLocation(locationName), 1, &value[0]); 
     }
     void setVec2(const std::string &locationName, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(programID, locationName.c_str()), x, y); 
+        glUniform2f(getUniformLocation(locationName), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &locationName, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(programID, locationName.c_str()), 1, &value[0]); 
+        glUniform3fv(getUniformLocation(locationName), 1, &value[0]); 
     }
     void setVec3(const std::string &locationName, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(programID, locationName.c_str()), x, y, z); 
+        glUniform3f(getUniformLocation(locationName), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &locationName, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(programID, locationName.c_str()), 1, &value[0]); 
+        glUniform4fv(getUniformLocation(locationName), 1, &value[0]); 
     }
     void setVec4(const std::string &locationName, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(programID, locationName.c_str()), x, y, z, w); 
+        glUniform4f(getUniformLocation(locationName), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &locationName, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(programID, locationName.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        glUniformMatrix2fv(getUniformLocation(locationName), 1, GL_FALSE, glm::value_ptr(mat));
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &locationName, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(programID, locationName.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        glUniformMatrix3fv(getUniformLocation(locationName), 1, GL_FALSE, glm::value_ptr(mat));
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &locationName, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(programID, locationName.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        glUniformMatrix4fv(getUniformLocation(locationName), 1, GL_FALSE, glm::value_ptr(mat));
+    }
+    // for per object uniforms, with the location looked up once by the caller
+    void setMat4(GLint location, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
     }
 
 private:
@@ -140,6 +156,8 @@ private:
     char* fragmentName;
     bool loaded = false;
     std::unordered_map<std::string, GLint> uniformLocations;
+    // fills uniformLocations with every active uniform and binds the Camera block
+    void cacheUniforms();
     std::string loadShaderSource(const std::string &filePath)
     {
         std::ifstream shaderFile;
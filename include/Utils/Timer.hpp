@@ -1,5 +1,6 @@
 #pragma once
 #include <GLFW/glfw3.h>
+#include <cmath>
 #include <iostream>
 namespace Utils
 {
@@ -46,6 +47,34 @@ namespace Utils
             return simTime;
         }
 
+        // fixed amount of simulated seconds advanced by one physics step
+        double getSimStep()
+        {
+            return simStep;
+        }
+
+        void setSimStep(double step)
+        {
+            if (step > 0.0)
+                simStep = step;
+        }
+
+        int getMaxSimStepsPerFrame()
+        {
+            return maxSimStepsPerFrame;
+        }
+
+        void setMaxSimStepsPerFrame(int steps)
+        {
+            if (steps > 0)
+                maxSimStepsPerFrame = steps;
+        }
+
+        int getSimStepsLastFrame()
+        {
+            return simStepsLastFrame;
+        }
+
         void updateDeltaTime()
         {
             currentTime = glfwGetTime();
@@ -53,6 +82,36 @@ namespace Utils
             deltaSimTime = deltaTime * timeMultiplier;
             simTime+=deltaSimTime;
             previousTime = currentTime;
+
+            simAccumulator += deltaSimTime;
+            simStepsLastFrame = 0;
+        }
+
+        /*
+            returns true while the sim time gathered this frame still covers a full step
+            and consumes that step, so the caller loops : while(consumeSimStep()) step(getSimStep())
+
+            past maxSimStepsPerFrame the leftover time is dropped, the simulation then
+            runs slower than requested instead of spending ever longer frames catching up
+        */
+        bool consumeSimStep()
+        {
+            if (simAccumulator < simStep)
+                return false;
+            if (simStepsLastFrame >= maxSimStepsPerFrame)
+            {
+                simAccumulator = std::fmod(simAccumulator, simStep);
+                return false;
+            }
+            simAccumulator -= simStep;
+            simStepsLastFrame++;
+            return true;
+        }
+
+        // how far render time is between the last two physics states, in [0,1)
+        float getInterpolationAlpha()
+        {
+            return static_cast<float>(simAccumulator / simStep);
         }
 
     private:
@@ -66,7 +125,12 @@ namespace Utils
         float previousTime;
         float currentTime; // application time
         float simTime; // simulation time
-        
+
+        double simStep = 1.0 / 60.0;
+        double simAccumulator = 0.0; // sim time not yet consumed by physics steps
+        int maxSimStepsPerFrame = 64;
+        int simStepsLastFrame = 0;
+
     };
     
 }
@@ -0,0 +1,98 @@
+#include "Utils/Trace.hpp"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+Trace *Trace::instance = nullptr;
+thread_local Trace::Buffer *Trace::local = nullptr;
+
+Trace::Buffer *Trace::registerThread()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(std::make_unique<Buffer>());
+    local = buffers.back().get();
+    local->thread = buffers.size() - 1;
+    // a thread that shows up mid capture keeps all it records
+    local->captured = 0;
+    return local;
+}
+
+void Trace::record(const char *name, uint64_t begin, uint64_t end)
+{
+    Buffer *buffer = local ? local : registerThread();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head & (Capacity - 1)] = Event{name, begin, end};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Trace::capture(size_t frames, const std::string &file)
+{
+    if (frames == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &buffer : buffers)
+            buffer->captured = buffer->head.load(std::memory_order_acquire);
+    }
+    path = file;
+    framesLeft = frames;
+    captureStart = frameStart = now();
+    recording.store(true, std::memory_order_release);
+}
+
+void Trace::frame()
+{
+    if (!isRecording())
+        return;
+    uint64_t end = now();
+    record("frame", frameStart, end);
+    frameStart = end;
+    if (--framesLeft > 0)
+        return;
+
+    recording.store(false, std::memory_order_release);
+    if (write(path))
+        std::cout << "trace : " << written << " events written to " << path << ", " << dropped << " dropped" << std::endl;
+}
+
+bool Trace::write(const std::string &file)
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        std::cerr << "ERROR::TRACE: could not write " << file << std::endl;
+        return false;
+    }
+
+    written = dropped = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &buffer : buffers)
+    {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t from = buffer->captured;
+        // the ring only holds the last Capacity events
+        if (head - from > Capacity)
+        {
+            dropped += head - from - Capacity;
+            from = head - Capacity;
+        }
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+            << ",\"args\":{\"name\":\"thread " << buffer->thread << "\"}}";
+        first = false;
+        for (uint64_t k = from; k < head; k++)
+        {
+            const Event &event = buffer->events[k & (Capacity - 1)];
+            if (event.begin < captureStart)
+                continue;
+            // microseconds since the capture started
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+                << ",\"ts\":" << (event.begin - captureStart) / 1e3 << ",\"dur\":" << (event.end - event.begin) / 1e3 << "}";
+            written++;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
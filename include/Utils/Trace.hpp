@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    frame traces in the Chrome trace-event format (chrome://tracing, ui.perfetto.dev)
+
+    TRACE_SCOPE(name) marks where a scope begins and ends, on any thread.
+    each thread writes into its own ring of events, registered the first
+    time it records, so recording takes no lock : a relaxed flag load when
+    idle, two clock reads and one store while capturing. a full ring
+    overwrites its oldest events, they are counted as dropped. capture()
+    starts recording and the frame() calls at the end of every frame count
+    it down, the file is written from the last one. names must be string
+    literals, only the pointer is kept.
+    building without EARTH_SIM_TRACE leaves no trace of the markers
+*/
+class Trace {
+public:
+        Trace(const Trace &obj) = delete;
+        static Trace *getInstance()
+        {
+            if (instance != nullptr)
+            {
+                return instance;
+            }
+            instance = new Trace();
+            return instance;
+        }
+
+    class Scope {
+    public:
+        explicit Scope(const char *name)
+            : name(name), begin(Trace::getInstance()->isRecording() ? now() : 0) {}
+        ~Scope()
+        {
+            if (begin != 0)
+                Trace::getInstance()->record(name, begin, now());
+        }
+    private:
+        const char *name;
+        uint64_t begin;
+    };
+
+    // records the next frames, then writes them to path
+    void capture(size_t frames, const std::string &path);
+    // ends a frame, only does something while capturing
+    void frame();
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+    size_t getFramesLeft() const { return framesLeft; }
+
+    void record(const char *name, uint64_t begin, uint64_t end);
+    // the events of the last capture, false if the file can not be written
+    bool write(const std::string &path);
+
+    // events written and dropped by the last write
+    size_t getWritten() const { return written; }
+    size_t getDropped() const { return dropped; }
+
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // events each thread keeps, a power of two
+    static constexpr size_t Capacity = 1 << 16;
+
+private:
+    static Trace *instance;
+    Trace() = default;
+
+    struct Event {
+        const char *name;
+        uint64_t begin, end;
+    };
+    struct Buffer {
+        std::vector<Event> events = std::vector<Event>(Capacity);
+        std::atomic<uint64_t> head{0}; // events ever recorded, only the owning thread writes it
+        uint64_t captured = 0;         // head when the capture started
+        size_t thread = 0;
+    };
+
+    Buffer *registerThread();
+
+    static thread_local Buffer *local;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    std::atomic<bool> recording{false};
+    size_t framesLeft = 0;
+    std::string path;
+    uint64_t captureStart = 0, frameStart = 0;
+    size_t written = 0, dropped = 0;
+};
+
+#ifdef EARTH_SIM_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
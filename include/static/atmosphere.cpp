@@ -0,0 +1,125 @@
+#include "atmosphere.hpp"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace {
+    constexpr double tableStep = 250.0; // m between samples
+    constexpr double earthRadius = 6356766.0;  // m, US76 radius for geopotential altitude
+    constexpr double gasConstant = 287.053;    // J/(kg K) of dry air
+    constexpr double hydrostatic = 0.0341632;  // g0 * M / R in K/m
+
+    struct Layer {
+        double base;  // geopotential altitude, m
+        double lapse; // K/m
+    };
+    // 1976 layers, temperature and pressure at each base follow from the one below
+    const Layer layers[] = {
+        {0.0, -0.0065}, {11000.0, 0.0}, {20000.0, 0.001}, {32000.0, 0.0028},
+        {47000.0, 0.0}, {51000.0, -0.0028}, {71000.0, -0.002},
+    };
+
+    struct ExponentialBand {
+        double base;        // geometric altitude, km
+        double density;     // kg/m³ at the base
+        double scaleHeight; // km
+    };
+    // Vallado, Fundamentals of Astrodynamics, table 8-4, from the band containing 86 km up
+    const ExponentialBand bands[] = {
+        {80, 1.905e-5, 5.799},    {90, 3.396e-6, 5.382},    {100, 5.297e-7, 5.877},
+        {110, 9.661e-8, 7.263},   {120, 2.438e-8, 9.473},   {130, 8.484e-9, 12.636},
+        {140, 3.845e-9, 16.149},  {150, 2.070e-9, 22.523},  {180, 5.464e-10, 29.740},
+        {200, 2.789e-10, 37.105}, {250, 7.248e-11, 45.546}, {300, 2.418e-11, 53.628},
+        {350, 9.518e-12, 53.298}, {400, 3.725e-12, 58.515}, {450, 1.585e-12, 60.828},
+        {500, 6.967e-13, 63.822}, {600, 1.454e-13, 71.835}, {700, 3.614e-14, 88.667},
+        {800, 1.170e-14, 124.64}, {900, 5.245e-15, 181.05}, {1000, 3.019e-15, 268.00},
+    };
+
+    double layeredDensity(double altitude)
+    {
+        double h = earthRadius * altitude / (earthRadius + altitude);
+        double temperature = 288.15;
+        double pressure = 101325.0;
+        size_t count = sizeof(layers) / sizeof(layers[0]);
+        for (size_t i = 0; i < count; i++)
+        {
+            double top = i + 1 < count ? layers[i + 1].base : h;
+            double span = std::fmin(h, top) - layers[i].base;
+            double lapse = layers[i].lapse;
+            if (lapse == 0.0)
+                pressure *= std::exp(-hydrostatic * span / temperature);
+            else
+                pressure *= std::pow(temperature / (temperature + lapse * span), hydrostatic / lapse);
+            temperature += lapse * span;
+            if (h <= top)
+                break;
+        }
+        return pressure / (gasConstant * temperature);
+    }
+
+    // continues the 86 km value of the layers with the band's scale height
+    double extendedDensity(double altitude)
+    {
+        size_t band = 0;
+        size_t count = sizeof(bands) / sizeof(bands[0]);
+        while (band + 1 < count && altitude >= bands[band + 1].base * 1e3)
+            band++;
+        double continuity = 1.0;
+        if (band == 0)
+            continuity = layeredDensity(Atmosphere::LowerAtmosphereTop) /
+                         (bands[0].density * std::exp(-(Atmosphere::LowerAtmosphereTop - bands[0].base * 1e3) / (bands[0].scaleHeight * 1e3)));
+        return continuity * bands[band].density * std::exp(-(altitude - bands[band].base * 1e3) / (bands[band].scaleHeight * 1e3));
+    }
+
+    std::atomic<bool> extension{true};
+
+    std::vector<double> buildTable(double top)
+    {
+        size_t samples = static_cast<size_t>(top / tableStep) + 1;
+        std::vector<double> logDensity(samples);
+        for (size_t i = 0; i < samples; i++)
+        {
+            double altitude = i * tableStep;
+            double rho = altitude <= Atmosphere::LowerAtmosphereTop ? layeredDensity(altitude) : extendedDensity(altitude);
+            logDensity[i] = std::log(rho);
+        }
+        return logDensity;
+    }
+
+    // both tables are built once, on the first lookup from any thread, and never change,
+    // so the stepping workers can read them while the extension is toggled
+    const std::vector<double> &table()
+    {
+        static const std::vector<double> extended = buildTable(Atmosphere::ExtensionTop);
+        static const std::vector<double> lower = buildTable(Atmosphere::LowerAtmosphereTop);
+        return extension.load(std::memory_order_relaxed) ? extended : lower;
+    }
+}
+
+double Atmosphere::density(double altitudeMeters)
+{
+    const std::vector<double> &samples = table();
+    double position = std::fmax(altitudeMeters, 0.0) / tableStep;
+    double last = samples.size() - 1;
+    if (position > last)
+        return 0.0;
+    size_t i = static_cast<size_t>(std::fmin(position, last - 1));
+    double t = position - i;
+    return std::exp(samples[i] + (samples[i + 1] - samples[i]) * t);
+}
+
+void Atmosphere::density(const double *altitudeMeters, double *rho, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        rho[i] = density(altitudeMeters[i]);
+}
+
+void Atmosphere::setHighAltitudeExtension(bool enabled)
+{
+    extension.store(enabled, std::memory_order_relaxed);
+}
+
+bool Atmosphere::highAltitudeExtension()
+{
+    return extension.load(std::memory_order_relaxed);
+}
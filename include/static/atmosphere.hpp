@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+namespace Atmosphere {
+     /*
+        air density of the US Standard Atmosphere 1976
+
+        the seven layers up to 86 km come from the barometric formula, above
+        that an exponential extension (Vallado's piecewise scale heights, up to
+        1000 km) can be switched on. both are sampled once into a table of log
+        density every 250 m, lookups are one linear interpolation
+     */
+
+     // kg/m³ at a geometric altitude in meters, clamped to sea level below 0, 0 above the table
+     double density(double altitudeMeters);
+     void density(const double *altitudeMeters, double *rho, size_t count);
+
+     // on by default, off leaves the air at 0 above 86 km
+     void setHighAltitudeExtension(bool enabled);
+     bool highAltitudeExtension();
+
+     constexpr double SeaLevelDensity = 1.225;   // kg/m³
+     constexpr double LowerAtmosphereTop = 86e3; // m, top of the 1976 layers
+     constexpr double ExtensionTop = 1000e3;     // m, top of the exponential extension
+};
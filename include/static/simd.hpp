@@ -0,0 +1,209 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+    minimal pack of doubles for the batch kernels
+
+    kernels are written once against Pack/Mask and compile to AVX2 (4 lanes),
+    SSE2 (2 lanes) or plain doubles depending on the target flags, so there is
+    no runtime dispatch. atan2 and sincos are Cephes style polynomial
+    approximations, accurate to a few ulp over the ranges geodesy needs
+*/
+namespace Simd {
+
+#if defined(__AVX2__)
+
+    struct Pack {
+        __m256d v;
+        static constexpr size_t width = 4;
+    };
+    struct Mask {
+        __m256d v;
+    };
+
+    inline Pack load(const double *p) { return {_mm256_loadu_pd(p)}; }
+    inline void store(double *p, Pack a) { _mm256_storeu_pd(p, a.v); }
+    inline Pack set(double a) { return {_mm256_set1_pd(a)}; }
+
+    inline Pack operator+(Pack a, Pack b) { return {_mm256_add_pd(a.v, b.v)}; }
+    inline Pack operator-(Pack a, Pack b) { return {_mm256_sub_pd(a.v, b.v)}; }
+    inline Pack operator*(Pack a, Pack b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    inline Pack operator/(Pack a, Pack b) { return {_mm256_div_pd(a.v, b.v)}; }
+    inline Pack operator-(Pack a) { return {_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))}; }
+    inline Pack sqrt(Pack a) { return {_mm256_sqrt_pd(a.v)}; }
+    inline Pack abs(Pack a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+    inline Pack floor(Pack a) { return {_mm256_floor_pd(a.v)}; }
+
+    inline Mask operator<(Pack a, Pack b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+    inline Mask operator>(Pack a, Pack b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+    inline Mask operator>=(Pack a, Pack b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)}; }
+    inline Mask operator==(Pack a, Pack b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+    inline Mask operator&(Mask a, Mask b) { return {_mm256_and_pd(a.v, b.v)}; }
+    inline Mask operator|(Mask a, Mask b) { return {_mm256_or_pd(a.v, b.v)}; }
+    inline Mask operator^(Mask a, Mask b) { return {_mm256_xor_pd(a.v, b.v)}; }
+    // mask ? a : b per lane
+    inline Pack select(Mask mask, Pack a, Pack b) { return {_mm256_blendv_pd(b.v, a.v, mask.v)}; }
+
+#elif defined(__SSE2__)
+
+    struct Pack {
+        __m128d v;
+        static constexpr size_t width = 2;
+    };
+    struct Mask {
+        __m128d v;
+    };
+
+    inline Pack load(const double *p) { return {_mm_loadu_pd(p)}; }
+    inline void store(double *p, Pack a) { _mm_storeu_pd(p, a.v); }
+    inline Pack set(double a) { return {_mm_set1_pd(a)}; }
+
+    inline Pack operator+(Pack a, Pack b) { return {_mm_add_pd(a.v, b.v)}; }
+    inline Pack operator-(Pack a, Pack b) { return {_mm_sub_pd(a.v, b.v)}; }
+    inline Pack operator*(Pack a, Pack b) { return {_mm_mul_pd(a.v, b.v)}; }
+    inline Pack operator/(Pack a, Pack b) { return {_mm_div_pd(a.v, b.v)}; }
+    inline Pack operator-(Pack a) { return {_mm_xor_pd(a.v, _mm_set1_pd(-0.0))}; }
+    inline Pack sqrt(Pack a) { return {_mm_sqrt_pd(a.v)}; }
+    inline Pack abs(Pack a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+
+    inline Mask operator<(Pack a, Pack b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+    inline Mask operator>(Pack a, Pack b) { return {_mm_cmpgt_pd(a.v, b.v)}; }
+    inline Mask operator>=(Pack a, Pack b) { return {_mm_cmpge_pd(a.v, b.v)}; }
+    inline Mask operator==(Pack a, Pack b) { return {_mm_cmpeq_pd(a.v, b.v)}; }
+    inline Mask operator&(Mask a, Mask b) { return {_mm_and_pd(a.v, b.v)}; }
+    inline Mask operator|(Mask a, Mask b) { return {_mm_or_pd(a.v, b.v)}; }
+    inline Mask operator^(Mask a, Mask b) { return {_mm_xor_pd(a.v, b.v)}; }
+    inline Pack select(Mask mask, Pack a, Pack b) { return {_mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v))}; }
+
+    // SSE2 has no rounding instruction, go through int32 (enough for the reduced ranges used here)
+    inline Pack floor(Pack a)
+    {
+        Pack t = {_mm_cvtepi32_pd(_mm_cvttpd_epi32(a.v))};
+        return select(a < t, t - set(1.0), t);
+    }
+
+#else
+
+    struct Pack {
+        double v;
+        static constexpr size_t width = 1;
+    };
+    struct Mask {
+        bool v;
+    };
+
+    inline Pack load(const double *p) { return {*p}; }
+    inline void store(double *p, Pack a) { *p = a.v; }
+    inline Pack set(double a) { return {a}; }
+
+    inline Pack operator+(Pack a, Pack b) { return {a.v + b.v}; }
+    inline Pack operator-(Pack a, Pack b) { return {a.v - b.v}; }
+    inline Pack operator*(Pack a, Pack b) { return {a.v * b.v}; }
+    inline Pack operator/(Pack a, Pack b) { return {a.v / b.v}; }
+    inline Pack operator-(Pack a) { return {-a.v}; }
+    inline Pack sqrt(Pack a) { return {std::sqrt(a.v)}; }
+    inline Pack abs(Pack a) { return {std::fabs(a.v)}; }
+    inline Pack floor(Pack a) { return {std::floor(a.v)}; }
+
+    inline Mask operator<(Pack a, Pack b) { return {a.v < b.v}; }
+    inline Mask operator>(Pack a, Pack b) { return {a.v > b.v}; }
+    inline Mask operator>=(Pack a, Pack b) { return {a.v >= b.v}; }
+    inline Mask operator==(Pack a, Pack b) { return {a.v == b.v}; }
+    inline Mask operator&(Mask a, Mask b) { return {a.v && b.v}; }
+    inline Mask operator|(Mask a, Mask b) { return {a.v || b.v}; }
+    inline Mask operator^(Mask a, Mask b) { return {a.v != b.v}; }
+    inline Pack select(Mask mask, Pack a, Pack b) { return mask.v ? a : b; }
+
+#endif
+
+    constexpr size_t width = Pack::width;
+
+    // c[0]*x^n + ... + c[n]
+    template <size_t N>
+    inline Pack polynomial(Pack x, const double (&c)[N])
+    {
+        Pack result = set(c[0]);
+        for (size_t i = 1; i < N; i++)
+            result = result * x + set(c[i]);
+        return result;
+    }
+
+    inline Pack atan(Pack x)
+    {
+        static const double P[] = {-8.750608600031904122785E-1, -1.615753718733365076637E1, -7.500855792314704667340E1,
+                                   -1.228866684490136173410E2, -6.485021904942025371773E1};
+        static const double Q[] = {1.0, 2.485846490142306297962E1, 1.650270098316988542046E2, 4.328810604912902668951E2,
+                                   4.853903996359136964868E2, 1.945506571482613964425E2};
+        const double moreBits = 6.123233995736765886130E-17;
+
+        Mask negative = x < set(0.0);
+        Pack a = abs(x);
+
+        // reduce to |a| <= tan(pi/8)
+        Mask big = a > set(2.41421356237309504880);
+        Mask medium = (a > set(0.66)) ^ big;
+        Pack offset = select(big, set(M_PI_2), select(medium, set(M_PI_4), set(0.0)));
+        Pack extra = select(big, set(moreBits), select(medium, set(0.5 * moreBits), set(0.0)));
+        Pack reduced = select(big, -(set(1.0) / a), select(medium, (a - set(1.0)) / (a + set(1.0)), a));
+
+        Pack z = reduced * reduced;
+        Pack p = z * polynomial(z, P) / polynomial(z, Q);
+        Pack result = offset + (reduced * p + extra) + reduced;
+        return select(negative, -result, result);
+    }
+
+    inline Pack atan2(Pack y, Pack x)
+    {
+        Pack result = atan(y / x);
+        // x == 0 divides to +-inf which atan maps to +-pi/2, only 0/0 needs care
+        Mask origin = (x == set(0.0)) & (y == set(0.0));
+        result = select(origin, set(0.0), result);
+        Mask left = x < set(0.0);
+        Pack turn = select(y >= set(0.0), set(M_PI), set(-M_PI));
+        return select(left, result + turn, result);
+    }
+
+    inline void sincos(Pack x, Pack &s, Pack &c)
+    {
+        static const double sinCoefficients[] = {1.58962301576546568060E-10, -2.50507477628578072866E-8,
+                                                 2.75573136213857245213E-6, -1.98412698295895385996E-4,
+                                                 8.33333333332211858878E-3, -1.66666666666666307295E-1};
+        static const double cosCoefficients[] = {-1.13585365213876817300E-11, 2.08757008419747316778E-9,
+                                                 -2.75573141792967388112E-7, 2.48015872888517045348E-5,
+                                                 -1.38888888888730564116E-3, 4.16666666666665929218E-2};
+        const double DP1 = 7.85398125648498535156E-1;
+        const double DP2 = 3.77489470793079817668E-8;
+        const double DP3 = 2.69515142907905952645E-15;
+
+        Mask negative = x < set(0.0);
+        Pack a = abs(x);
+
+        // octant, rounded up to even so the remainder lands in [-pi/4, pi/4]
+        Pack j = floor(a * set(4.0 / M_PI));
+        j = j + (j - set(2.0) * floor(j * set(0.5)));
+        Pack octant = j - set(8.0) * floor(j * set(0.125)); // 0, 2, 4 or 6
+
+        Pack r = ((a - j * set(DP1)) - j * set(DP2)) - j * set(DP3);
+        Pack rr = r * r;
+        Pack sinR = r + r * rr * polynomial(rr, sinCoefficients);
+        Pack cosR = set(1.0) - set(0.5) * rr + rr * rr * polynomial(rr, cosCoefficients);
+
+        Mask swap = (octant == set(2.0)) | (octant == set(6.0));
+        Mask upper = octant >= set(4.0);
+        Pack sinValue = select(swap, cosR, sinR);
+        Pack cosValue = select(swap, sinR, cosR);
+
+        // sin flips in the upper half and for negative input, cos flips in octants 2 and 4
+        Mask sinFlip = upper ^ negative;
+        Mask cosFlip = (octant == set(2.0)) | (octant == set(4.0));
+        s = select(sinFlip, -sinValue, sinValue);
+        c = select(cosFlip, -cosValue, cosValue);
+    }
+}
@@ -1,4 +1,5 @@
 #include "wgs84.hpp"
+#include "simd.hpp"
 
 glm::vec3 WGS84::toCartesian(double latitude,double longitude, double altitude) {
     double radLong = glm::radians(longitude);
@@ -58,3 +59,285 @@ double WGS84::gravityAtHeight(double latitude, double altitude) {
     return g0 * pow((A / (A + altitude)), 2);
 }
 
+
+// ---------------------------------------------------------------------------
+// batch kernels
+// ---------------------------------------------------------------------------
+
+namespace {
+    using namespace Simd;
+
+    // runs kernel over full packs, the tail is padded into a scratch pack so every point takes the same path
+    template <size_t Inputs, size_t Outputs, class Kernel>
+    void forEachPack(const double *const (&in)[Inputs], double *const (&out)[Outputs], size_t count, Kernel kernel)
+    {
+        size_t i = 0;
+        for (; i + width <= count; i += width)
+        {
+            Pack a[Inputs], r[Outputs];
+            for (size_t k = 0; k < Inputs; k++)
+                a[k] = load(in[k] + i);
+            kernel(a, r);
+            for (size_t k = 0; k < Outputs; k++)
+                store(out[k] + i, r[k]);
+        }
+        if (i == count)
+            return;
+
+        size_t rest = count - i;
+        double scratchIn[Inputs][width], scratchOut[Outputs][width];
+        Pack a[Inputs], r[Outputs];
+        for (size_t k = 0; k < Inputs; k++)
+        {
+            for (size_t lane = 0; lane < width; lane++)
+                scratchIn[k][lane] = in[k][i + (lane < rest ? lane : rest - 1)];
+            a[k] = load(scratchIn[k]);
+        }
+        kernel(a, r);
+        for (size_t k = 0; k < Outputs; k++)
+        {
+            store(scratchOut[k], r[k]);
+            for (size_t lane = 0; lane < rest; lane++)
+                out[k][i + lane] = scratchOut[k][lane];
+        }
+    }
+
+    const Pack toRadians = set(M_PI / 180.0);
+    const Pack toDegrees = set(180.0 / M_PI);
+}
+
+size_t WGS84::batchWidth() {
+    return Simd::width;
+}
+
+void WGS84::toGeodetic(const double *x, const double *y, const double *z,
+                       double *longitude, double *latitude, double *height, size_t count) {
+    // same single pass Bowring as the scalar version, with sin/cos of the
+    // auxiliary and geodetic latitude taken from the atan2 arguments instead of trig calls
+    forEachPack<3, 3>({x, y, z}, {longitude, latitude, height}, count, [](const Pack *in, Pack *out) {
+        Pack px = in[0], py = in[1], pz = in[2];
+        Pack one = set(1.0);
+
+        Pack lon = atan2(py, px);
+        Pack p = sqrt(px * px + py * py);
+
+        Pack ta = pz * set(A), tb = p * set(B);
+        Pack tr = sqrt(ta * ta + tb * tb);
+        Mask origin = tr == set(0.0);
+        Pack sinTheta = select(origin, set(0.0), ta / tr);
+        Pack cosTheta = select(origin, one, tb / tr);
+
+        Pack num = pz + set(E2 / (1 - E2) * B) * sinTheta * sinTheta * sinTheta;
+        Pack den = p - set(E2 * A) * cosTheta * cosTheta * cosTheta;
+        Pack lat = atan2(num, den);
+
+        Pack nr = sqrt(num * num + den * den);
+        Pack sinLat = num / nr;
+        Pack cosLat = den / nr;
+        Pack N = set(A) / sqrt(one - set(E2) * sinLat * sinLat);
+
+        out[0] = lon * toDegrees;
+        out[1] = lat * toDegrees;
+        out[2] = p / cosLat - N;
+    });
+}
+
+void WGS84::toCartesian(const double *latitude, const double *longitude, const double *altitude,
+                        double *x, double *y, double *z, size_t count) {
+    forEachPack<3, 3>({latitude, longitude, altitude}, {x, y, z}, count, [](const Pack *in, Pack *out) {
+        Pack sinLat, cosLat, sinLon, cosLon;
+        sincos(in[0] * toRadians, sinLat, cosLat);
+        sincos(in[1] * toRadians, sinLon, cosLon);
+
+        Pack N = set(A) / sqrt(set(1.0) - set(E2) * sinLat * sinLat);
+        Pack h = in[2];
+
+        out[0] = (N + h) * cosLat * cosLon;
+        out[1] = (N + h) * cosLat * sinLon;
+        out[2] = (set(1 - E2) * N + h) * sinLat;
+    });
+}
+
+void WGS84::surfaceNormal(const double *longitude, const double *latitude,
+                          double *x, double *y, double *z, size_t count) {
+    forEachPack<2, 3>({longitude, latitude}, {x, y, z}, count, [](const Pack *in, Pack *out) {
+        Pack sinLon, cosLon, sinLat, cosLat;
+        sincos(in[0] * toRadians, sinLon, cosLon);
+        sincos(in[1] * toRadians, sinLat, cosLat);
+
+        // already unit length, the scalar normalize is a no-op
+        out[0] = cosLat * cosLon;
+        out[1] = cosLat * sinLon;
+        out[2] = sinLat;
+    });
+}
+
+void WGS84::gravityAtHeight(const double *latitude, const double *altitude, double *gravity, size_t count) {
+    forEachPack<2, 1>({latitude, altitude}, {gravity}, count, [](const Pack *in, Pack *out) {
+        Pack sinLat, cosLat;
+        sincos(in[0] * toRadians, sinLat, cosLat);
+        Pack sin2 = sinLat * sinLat;
+
+        Pack surface = set(9.7803267714) * (set(1.0) + set(0.00193185138639) * sin2) /
+                       sqrt(set(1.0) - set(E2) * sin2);
+        Pack ratio = set(A) / (set(A) + in[1]);
+        out[0] = surface * ratio * ratio;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// selectable geodetic conversions
+// ---------------------------------------------------------------------------
+
+namespace {
+    using WGS84::A;
+    using WGS84::B;
+    using WGS84::E2;
+
+    // error bounds per height band, see the table in wgs84.hpp
+    const double bandHeights[] = {10e3, 2000e3, 36000e3};
+
+    struct MethodInfo {
+        WGS84::GeodeticMethod method;
+        const char *name;
+        double maxErrorMeters[3];
+    };
+    const MethodInfo methods[] = {
+        {WGS84::GeodeticMethod::Bowring, "bowring", {2e-6, 5e-2, 1.0}},
+        {WGS84::GeodeticMethod::Zhu, "zhu", {1e-8, 1e-8, 5e-8}},
+        {WGS84::GeodeticMethod::Vermeille, "vermeille", {1e-8, 1e-8, 5e-8}},
+        {WGS84::GeodeticMethod::Newton, "newton", {1e-8, 1e-8, 5e-8}},
+    };
+
+    size_t heightBand(double maxHeightMeters) {
+        for (size_t band = 0; band < 2; band++)
+            if (maxHeightMeters <= bandHeights[band])
+                return band;
+        return 2;
+    }
+
+    // height from latitude, stable at every latitude unlike p / cos(lat) - N
+    double heightAt(double p, double z, double lat) {
+        double sinLat = std::sin(lat);
+        return p * std::cos(lat) + z * sinLat - A * std::sqrt(1.0 - E2 * sinLat * sinLat);
+    }
+
+    WGS84::GeodeticPosition bowring(double x, double y, double z) {
+        double p = std::sqrt(x * x + y * y);
+        double theta = std::atan2(z * A, p * B);
+        double sinTheta = std::sin(theta);
+        double cosTheta = std::cos(theta);
+        double e2 = E2 / (1 - E2);
+
+        double lat = std::atan2(z + e2 * B * sinTheta * sinTheta * sinTheta,
+                                p - E2 * A * cosTheta * cosTheta * cosTheta);
+        return {lat, std::atan2(y, x), heightAt(p, z, lat)};
+    }
+
+    WGS84::GeodeticPosition zhu(double x, double y, double z) {
+        const double a2 = A * A;
+        const double b2 = B * B;
+        const double ep2 = (a2 - b2) / b2;
+
+        double p = std::sqrt(x * x + y * y);
+        double F = 54.0 * b2 * z * z;
+        double G = p * p + (1 - E2) * z * z - E2 * (a2 - b2);
+        double c = E2 * E2 * F * p * p / (G * G * G);
+        double s = std::cbrt(1 + c + std::sqrt(c * c + 2 * c));
+        double k = s + 1 + 1 / s;
+        double P = F / (3 * k * k * G * G);
+        double Q = std::sqrt(1 + 2 * E2 * E2 * P);
+        double r0 = -P * E2 * p / (1 + Q) +
+                    std::sqrt(0.5 * a2 * (1 + 1 / Q) - P * (1 - E2) * z * z / (Q * (1 + Q)) - 0.5 * P * p * p);
+        double V = std::sqrt((p - E2 * r0) * (p - E2 * r0) + (1 - E2) * z * z);
+        double z0 = b2 * z / (A * V);
+
+        double lat = std::atan2(z + ep2 * z0, p);
+        return {lat, std::atan2(y, x), heightAt(p, z, lat)};
+    }
+
+    WGS84::GeodeticPosition vermeille(double x, double y, double z) {
+        const double e4 = E2 * E2;
+
+        double p = (x * x + y * y) / (A * A);
+        double q = (1 - E2) * z * z / (A * A);
+        double r = (p + q - e4) / 6;
+        double s = e4 * p * q / (4 * r * r * r);
+        double t = std::cbrt(1 + s + std::sqrt(s * (2 + s)));
+        double u = r * (1 + t + 1 / t);
+        double v = std::sqrt(u * u + e4 * q);
+        double w = E2 * (u + v - q) / (2 * v);
+        double k = std::sqrt(u + v + w * w) - w;
+        double horizontal = std::sqrt(x * x + y * y);
+        double D = k * horizontal / (k + E2);
+
+        double lat = 2 * std::atan2(z, D + std::sqrt(D * D + z * z));
+        return {lat, std::atan2(y, x), heightAt(horizontal, z, lat)};
+    }
+
+    WGS84::GeodeticPosition newton(double x, double y, double z) {
+        double p = std::sqrt(x * x + y * y);
+        double p2 = p * p;
+        double z2 = (1 - E2) * z * z;
+
+        // Newton-Raphson on Bowring's irrational equation in kappa, where tan(lat) = kappa * z / p
+        double kappa = 1 / (1 - E2);
+        for (int i = 0; i < 16; i++)
+        {
+            double c = std::pow(p2 + z2 * kappa * kappa, 1.5) / (A * E2);
+            double next = 1 + (p2 + z2 * kappa * kappa * kappa) / (c - p2);
+            bool done = std::fabs(next - kappa) <= 1e-15 * kappa;
+            kappa = next;
+            if (done)
+                break;
+        }
+
+        double lat = std::atan2(kappa * z, p);
+        return {lat, std::atan2(y, x), heightAt(p, z, lat)};
+    }
+}
+
+WGS84::GeodeticPosition WGS84::toGeodetic(double x, double y, double z, GeodeticMethod method) {
+    GeodeticPosition result;
+    switch (method)
+    {
+    case GeodeticMethod::Bowring:
+        result = bowring(x, y, z);
+        break;
+    case GeodeticMethod::Zhu:
+        result = zhu(x, y, z);
+        break;
+    case GeodeticMethod::Vermeille:
+        result = vermeille(x, y, z);
+        break;
+    default:
+        result = newton(x, y, z);
+        break;
+    }
+    result.latitude = glm::degrees(result.latitude);
+    result.longitude = glm::degrees(result.longitude);
+    return result;
+}
+
+double WGS84::geodeticMaxError(GeodeticMethod method, double maxHeightMeters) {
+    for (const auto &info : methods)
+        if (info.method == method)
+            return info.maxErrorMeters[heightBand(maxHeightMeters)];
+    return 0.0;
+}
+
+WGS84::GeodeticMethod WGS84::geodeticMethodFor(double maxErrorMeters, double maxHeightMeters) {
+    // methods is ordered by cost
+    size_t band = heightBand(maxHeightMeters);
+    for (const auto &info : methods)
+        if (info.maxErrorMeters[band] <= maxErrorMeters)
+            return info.method;
+    return GeodeticMethod::Newton;
+}
+
+const char *WGS84::geodeticMethodName(GeodeticMethod method) {
+    for (const auto &info : methods)
+        if (info.method == method)
+            return info.name;
+    return "unknown";
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <cmath>
+#include <cstddef>
 
 
 
@@ -11,6 +12,54 @@ namespace WGS84 {
      glm::vec3 toGeodetic(const glm::vec3& position);
      double gravityOnSurface(double latitude);
      double gravityAtHeight(double latitude, double altitude);
+
+     /*
+        batch versions, count points from plain arrays (the BodyStore columns)
+        each output holds the same value the scalar function returns for that point.
+        built with AVX2 they run 4 points per instruction, 2 with SSE2, else one by one
+     */
+     void toGeodetic(const double *x, const double *y, const double *z,
+                     double *longitude, double *latitude, double *height, size_t count);
+     void toCartesian(const double *latitude, const double *longitude, const double *altitude,
+                      double *x, double *y, double *z, size_t count);
+     void surfaceNormal(const double *longitude, const double *latitude,
+                        double *x, double *y, double *z, size_t count);
+     void gravityAtHeight(const double *latitude, const double *altitude, double *gravity, size_t count);
+     // points per batch instruction in this build
+     size_t batchWidth();
+
+     /*
+        ECEF -> geodetic algorithms, cheapest first. errors are the worst 3D position
+        error (converted back to ECEF) measured by wgs_bench, rounded up :
+
+                        |h| < 10 km    h < 2000 km    h < 36000 km
+        Bowring         2e-6 m         5e-2 m         1 m
+        Zhu             1e-8 m         1e-8 m         5e-8 m
+        Vermeille       1e-8 m         1e-8 m         5e-8 m
+        Newton          1e-8 m         1e-8 m         5e-8 m
+
+        the closed forms and Newton all sit on the double precision floor of engine
+        units (~1e-9 m per ulp at earth radius), Newton is kept as the reference
+     */
+     enum class GeodeticMethod {
+         Bowring,   // single pass Bowring, what toGeodetic(glm::vec3) and the batch kernel use
+         Zhu,       // Heikkinen closed form as given by Zhu
+         Vermeille, // Vermeille closed form
+         Newton     // Newton-Raphson on Bowring's latitude equation, iterated to convergence
+     };
+
+     struct GeodeticPosition {
+         double latitude;  // degrees
+         double longitude; // degrees
+         double height;    // engine units above the ellipsoid
+     };
+
+     GeodeticPosition toGeodetic(double x, double y, double z, GeodeticMethod method);
+     // documented worst case error in meters for points up to maxHeight meters above the ellipsoid
+     double geodeticMaxError(GeodeticMethod method, double maxHeightMeters = 36000e3);
+     // cheapest method whose documented error fits the budget, Newton if none does
+     GeodeticMethod geodeticMethodFor(double maxErrorMeters, double maxHeightMeters = 36000e3);
+     const char *geodeticMethodName(GeodeticMethod method);
      constexpr double UnitToMeterRatio = 0.0001q;
      constexpr double A = 6378137.0q * UnitToMeterRatio;           // Semi-major Axis in engine units
      constexpr double B = 6356752.314245q * UnitToMeterRatio;     // Semi-minor Axis in engine units
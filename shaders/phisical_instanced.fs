@@ -0,0 +1,38 @@
+#version 330 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 ObjectColor;
+
+out vec4 FragColor;
+
+uniform vec3 lightColor;
+uniform vec3 lightPos;
+// shared by every program, filled once per frame (Shader::updateCameraBlock)
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+void main() {
+    // Ambient
+    float ambientStrength = 0.1;
+    vec3 ambient = ambientStrength * lightColor;
+    
+    // Diffuse
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+    
+    // Specular
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);  
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * lightColor;  
+    
+    vec3 result = (ambient + diffuse + specular) * ObjectColor;
+    FragColor = vec4(result, 1.0);
+}
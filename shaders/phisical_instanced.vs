@@ -0,0 +1,27 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+// per instance
+layout(location = 2) in mat4 model;
+layout(location = 6) in vec3 aColour;
+
+// shared by every program, filled once per frame (Shader::updateCameraBlock)
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 ObjectColor;
+
+void main() {
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    // instances are only rotated and moved, the model matrix itself turns the normals
+    Normal = mat3(model) * aNormal;
+    ObjectColor = aColour;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -3,8 +3,12 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// shared by every program, filled once per frame (Shader::updateCameraBlock)
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+// per instance
+layout (location = 2) in mat4 model;
+layout (location = 6) in vec3 aColour;
+
+// shared by every program, filled once per frame (Shader::updateCameraBlock)
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+out vec3 Colour;
+
+void main() {
+    Colour = aColour;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,382 @@
+#include "static/wgs84.hpp"
+#include "Utils/Physics.hpp"
+#include "Utils/ConsoleArgs.hpp"
+#ifdef EARTH_SIM_BENCH_GL
+#include "Utils/Shader.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+    micro benchmarks of the engine's hot functions, results as JSON
+
+    every benchmark is calibrated to run about --time seconds per repetition,
+    then repeated --reps times. ns/op is the mean over the repetitions, the
+    variance is taken between repetitions, so a noisy machine shows up in
+    it instead of in the mean. results go into a sink so the loops are not
+    optimized away. the Shader setters run against stub GL entry points
+    (no context, the calls do nothing) and measure the engine side of a
+    uniform upload, they are only built with the viewer
+*/
+
+struct BenchOptions {
+    size_t repetitions = 10;
+    double seconds = 0.1;  // per repetition
+    std::string filter;    // only benchmarks whose name contains it
+    std::string out;       // JSON file, empty = stdout
+};
+
+struct Benchmark {
+    std::string name;
+    // runs ops operations, returns something derived from the results
+    std::function<double(size_t ops)> run;
+};
+
+struct BenchResult {
+    std::string name;
+    size_t ops;
+    std::vector<double> nsPerOp; // one per repetition
+};
+
+static volatile double sink = 0.0;
+
+static void printUsage()
+{
+    std::cout << "usage: earth_sim_bench [options]\n"
+              << "  --reps N     repetitions per benchmark (default 10)\n"
+              << "  --time S     seconds per repetition (default 0.1)\n"
+              << "  --filter S   only run benchmarks whose name contains S\n"
+              << "  --out FILE   write the JSON there instead of stdout\n";
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (i + 1 >= argc)
+        {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        try
+        {
+            if (arg == "--reps")
+                options.repetitions = std::stoul(value);
+            else if (arg == "--time")
+                options.seconds = std::stod(value);
+            else if (arg == "--filter")
+                options.filter = value;
+            else if (arg == "--out")
+                options.out = value;
+            else
+            {
+                std::cerr << "unknown option " << arg << std::endl;
+                return false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "invalid value for " << arg << " : " << value << std::endl;
+            return false;
+        }
+    }
+    return options.repetitions > 0 && options.seconds > 0.0;
+}
+
+static double secondsFor(const Benchmark &benchmark, size_t ops)
+{
+    auto start = std::chrono::steady_clock::now();
+    sink = sink + benchmark.run(ops);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static BenchResult measure(const Benchmark &benchmark, const BenchOptions &options)
+{
+    // doubles the op count until a run is long enough to scale from, which also warms up
+    size_t ops = 1;
+    double seconds = secondsFor(benchmark, ops);
+    while (seconds < options.seconds / 10)
+    {
+        ops *= 2;
+        seconds = secondsFor(benchmark, ops);
+    }
+    ops = std::max<size_t>(1, static_cast<size_t>(ops * options.seconds / seconds));
+
+    BenchResult result{benchmark.name, ops, {}};
+    for (size_t r = 0; r < options.repetitions; r++)
+        result.nsPerOp.push_back(secondsFor(benchmark, ops) * 1e9 / ops);
+    return result;
+}
+
+// random ECEF points and their geodetic coordinates, from the ground to low orbit
+struct Points {
+    std::vector<double> lat, lon, alt;
+    std::vector<double> x, y, z;
+};
+
+static Points makePoints(size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+    std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+    std::uniform_real_distribution<double> height(-10e3 * WGS84::UnitToMeterRatio, 2000e3 * WGS84::UnitToMeterRatio);
+
+    Points points;
+    for (auto column : {&points.lat, &points.lon, &points.alt, &points.x, &points.y, &points.z})
+        column->resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        points.lat[i] = latitude(rng);
+        points.lon[i] = longitude(rng);
+        points.alt[i] = height(rng);
+    }
+    WGS84::toCartesian(points.lat.data(), points.lon.data(), points.alt.data(),
+                       points.x.data(), points.y.data(), points.z.data(), count);
+    return points;
+}
+
+#ifdef EARTH_SIM_BENCH_GL
+/*
+    GL entry points for Shader with no context behind them : load() links a
+    program that reports the uniforms below, the setters go nowhere
+*/
+namespace StubGL {
+    const char *uniforms[] = {"model", "lightColor", "lightPos", "objectColor", "time"};
+    const GLint uniformCount = sizeof(uniforms) / sizeof(uniforms[0]);
+
+    void install()
+    {
+        __glewCreateShader = [](GLenum) -> GLuint { return 1; };
+        __glewShaderSource = [](GLuint, GLsizei, const GLchar *const *, const GLint *) {};
+        __glewCompileShader = [](GLuint) {};
+        __glewGetShaderiv = [](GLuint, GLenum, GLint *value) { *value = 1; };
+        __glewCreateProgram = []() -> GLuint { return 1; };
+        __glewAttachShader = [](GLuint, GLuint) {};
+        __glewLinkProgram = [](GLuint) {};
+        __glewDeleteShader = [](GLuint) {};
+        __glewDeleteProgram = [](GLuint) {};
+        __glewUseProgram = [](GLuint) {};
+        __glewGetProgramiv = [](GLuint, GLenum name, GLint *value) {
+            *value = name == GL_ACTIVE_UNIFORMS ? uniformCount : name == GL_ACTIVE_UNIFORM_MAX_LENGTH ? 32 : 1;
+        };
+        __glewGetActiveUniform = [](GLuint, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+            *length = static_cast<GLsizei>(std::min<size_t>(bufSize - 1, std::strlen(uniforms[index])));
+            std::memcpy(name, uniforms[index], *length);
+            name[*length] = '\0';
+            *size = 1;
+            *type = GL_FLOAT_VEC3;
+        };
+        __glewGetUniformLocation = [](GLuint, const GLchar *name) -> GLint {
+            for (GLint i = 0; i < uniformCount; i++)
+                if (std::strcmp(name, uniforms[i]) == 0)
+                    return i;
+            return -1;
+        };
+        __glewGetUniformBlockIndex = [](GLuint, const GLchar *) -> GLuint { return GL_INVALID_INDEX; };
+        __glewUniformBlockBinding = [](GLuint, GLuint, GLuint) {};
+        __glewUniform3fv = [](GLint, GLsizei, const GLfloat *) {};
+        __glewUniformMatrix4fv = [](GLint, GLsizei, GLboolean, const GLfloat *) {};
+    }
+};
+#endif
+
+static std::vector<Benchmark> makeBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+    // enough points to leave L1 but stay in L2, the ops walk them round robin
+    const size_t count = 4096;
+    auto points = std::make_shared<Points>(makePoints(count, 42));
+
+    benchmarks.push_back({"WGS84::toGeodetic", [points, count](size_t ops) {
+        double total = 0.0;
+        for (size_t k = 0; k < ops; k++)
+        {
+            size_t i = k % count;
+            total += WGS84::toGeodetic(glm::vec3(points->x[i], points->y[i], points->z[i])).z;
+        }
+        return total;
+    }});
+    benchmarks.push_back({"WGS84::toGeodetic batch", [points, count](size_t ops) {
+        std::vector<double> lon(count), lat(count), alt(count);
+        double total = 0.0;
+        for (size_t done = 0; done < ops; done += count)
+        {
+            size_t n = std::min(count, ops - done);
+            WGS84::toGeodetic(points->x.data(), points->y.data(), points->z.data(), lon.data(), lat.data(), alt.data(), n);
+            total += alt[0];
+        }
+        return total;
+    }});
+    benchmarks.push_back({"WGS84::toCartesian", [points, count](size_t ops) {
+        double total = 0.0;
+        for (size_t k = 0; k < ops; k++)
+        {
+            size_t i = k % count;
+            total += WGS84::toCartesian(points->lat[i], points->lon[i], points->alt[i]).x;
+        }
+        return total;
+    }});
+    benchmarks.push_back({"WGS84::toCartesian batch", [points, count](size_t ops) {
+        std::vector<double> x(count), y(count), z(count);
+        double total = 0.0;
+        for (size_t done = 0; done < ops; done += count)
+        {
+            size_t n = std::min(count, ops - done);
+            WGS84::toCartesian(points->lat.data(), points->lon.data(), points->alt.data(), x.data(), y.data(), z.data(), n);
+            total += x[0];
+        }
+        return total;
+    }});
+    benchmarks.push_back({"WGS84::gravityAtHeight", [points, count](size_t ops) {
+        double total = 0.0;
+        for (size_t k = 0; k < ops; k++)
+        {
+            size_t i = k % count;
+            total += WGS84::gravityAtHeight(points->lat[i], points->alt[i]);
+        }
+        return total;
+    }});
+    benchmarks.push_back({"WGS84::gravityAtHeight batch", [points, count](size_t ops) {
+        std::vector<double> gravity(count);
+        double total = 0.0;
+        for (size_t done = 0; done < ops; done += count)
+        {
+            size_t n = std::min(count, ops - done);
+            WGS84::gravityAtHeight(points->lat.data(), points->alt.data(), gravity.data(), n);
+            total += gravity[0];
+        }
+        return total;
+    }});
+    // no force on a body at rest : the step and its geodetic update, the body stays put
+    benchmarks.push_back({"Position::applyForce", [](size_t ops) {
+        Position position(45.0, 10.0, 1.0);
+        for (size_t k = 0; k < ops; k++)
+            position.applyForce(0.0, 0.0, 0.0, 1.0, 1.0 / 60.0);
+        return position.getAltitude();
+    }});
+    benchmarks.push_back({"GravityForce::apply", [](size_t ops) {
+        Position position(45.0, 10.0, 1.0);
+        GravityForce gravity;
+        for (size_t k = 0; k < ops; k++)
+            gravity.apply(position, 1.0, 1.0 / 60.0);
+        double fx, fy, fz;
+        position.getTotalForce(fx, fy, fz);
+        return fx + fy + fz;
+    }});
+    benchmarks.push_back({"Console::splitArgs", [](size_t ops) {
+        const std::string line = "near 45.5 -12.25 \"fifty km\" 50";
+        double total = 0.0;
+        for (size_t k = 0; k < ops; k++)
+            total += ConsoleArgs::split(line).size();
+        return total;
+    }});
+#ifdef EARTH_SIM_BENCH_GL
+    StubGL::install();
+    auto shader = std::make_shared<Shader>((char *)"bench", (char *)"bench");
+    shader->load();
+    benchmarks.push_back({"Shader::setVec3 by name", [shader](size_t ops) {
+        for (size_t k = 0; k < ops; k++)
+            shader->setVec3("lightPos", glm::vec3(k, 1.0f, 2.0f));
+        return 0.0;
+    }});
+    benchmarks.push_back({"Shader::setMat4 by name", [shader](size_t ops) {
+        glm::mat4 model(1.0f);
+        for (size_t k = 0; k < ops; k++)
+            shader->setMat4("model", model);
+        return 0.0;
+    }});
+    benchmarks.push_back({"Shader::setMat4 by location", [shader](size_t ops) {
+        glm::mat4 model(1.0f);
+        GLint location = shader->getUniformLocation("model");
+        for (size_t k = 0; k < ops; k++)
+            shader->setMat4(location, model);
+        return 0.0;
+    }});
+#endif
+    return benchmarks;
+}
+
+static std::string toJson(const std::vector<BenchResult> &results, const BenchOptions &options)
+{
+    std::ostringstream oss;
+    oss << std::setprecision(6);
+    oss << "{\n  \"repetitions\": " << options.repetitions << ",\n";
+    oss << "  \"seconds_per_repetition\": " << options.seconds << ",\n";
+    oss << "  \"batch_width\": " << WGS84::batchWidth() << ",\n";
+    oss << "  \"benchmarks\": [";
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        const BenchResult &result = results[k];
+        double mean = 0.0, best = result.nsPerOp[0];
+        for (double ns : result.nsPerOp)
+        {
+            mean += ns / result.nsPerOp.size();
+            best = std::min(best, ns);
+        }
+        double variance = 0.0;
+        for (double ns : result.nsPerOp)
+            variance += (ns - mean) * (ns - mean);
+        if (result.nsPerOp.size() > 1)
+            variance /= result.nsPerOp.size() - 1;
+
+        oss << (k == 0 ? "\n" : ",\n");
+        oss << "    {\"name\": \"" << result.name << "\", \"ops_per_repetition\": " << result.ops
+            << ", \"ns_per_op\": " << mean << ", \"ns_per_op_min\": " << best
+            << ", \"variance_ns2\": " << variance << ", \"stddev_ns\": " << std::sqrt(variance)
+            << ", \"ops_per_s\": " << (mean > 0.0 ? 1e9 / mean : 0.0) << "}";
+    }
+    oss << "\n  ]\n}\n";
+    return oss.str();
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchResult> results;
+    for (const Benchmark &benchmark : makeBenchmarks())
+    {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(measure(benchmark, options));
+        // progress on stderr, stdout stays plain JSON
+        std::cerr << benchmark.name << " : " << results.back().nsPerOp[0] << " ns/op" << std::endl;
+    }
+
+    std::string json = toJson(results, options);
+    if (options.out.empty())
+    {
+        std::cout << json;
+        return EXIT_SUCCESS;
+    }
+    std::ofstream file(options.out);
+    if (!file)
+    {
+        std::cerr << "could not write " << options.out << std::endl;
+        return EXIT_FAILURE;
+    }
+    file << json;
+    return EXIT_SUCCESS;
+}
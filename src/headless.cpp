@@ -0,0 +1,448 @@
+#include "Utils/BodyStore.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/GravityField.hpp"
+#include "Utils/Collisions.hpp"
+#include "Utils/GeoIndex.hpp"
+#include "Utils/Events.hpp"
+#include "Utils/Trace.hpp"
+#include "Utils/PerfCounters.hpp"
+#include "Objects/RockForces.hpp"
+#include "static/wgs84.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    render-less simulation runner
+
+    steps rock bodies with the same BodyStore and force stack as earth_sim
+    on a clock driven from the command line instead of glfwGetTime, then
+    prints throughput stats. no GLFW or GL is linked into this target
+*/
+
+struct HeadlessOptions {
+    size_t bodies = 1000;
+    size_t satellites = 0;         // orbital bodies under the harmonic gravity field
+    std::string gravityFile;       // coefficient file, empty = built-in J2
+    int degree = -1;               // harmonic degree, -1 = all the file holds
+    bool collisions = true;
+    bool sleep = true;             // resting bodies drop out of the step
+    size_t queries = 0;            // geodetic index radius queries per step, 0 = index off
+    double drag = 0.0;             // drag coefficient of the rocks and satellites, 0 = no drag
+    double keplerAltitude = 1000e3; // meters above which satellites coast on a conic, 0 = off
+    std::vector<double> eventAltitudes; // meters, crossings reported as events
+    double deltaTime = 1.0 / 60.0; // sim seconds per step
+    double duration = 60.0;        // sim seconds to run
+    double reportInterval = 0.0;   // sim seconds between progress lines, 0 = off
+    unsigned seed = 1;
+    size_t traceSteps = 0;         // steps written to trace.json from the start, 0 = off
+    size_t scalingBodies = 0;      // largest body count of the scaling sweep, 0 = one run
+    bool perf = false;             // hardware counters around the step
+    size_t threads = 0;            // 0 = one per hardware thread
+    Integrator integrator = Integrator::SemiImplicitEuler;
+    double tolerance = 1e-6;       // rk45 local error tolerance
+};
+
+static void printUsage()
+{
+    std::cout << "usage: earth_sim_headless [options]\n"
+              << "  --bodies N       number of rock bodies to spawn (default 1000)\n"
+              << "  --collisions B   on|off body vs body collisions (default on)\n"
+              << "  --sleep B        on|off resting bodies drop out of the step (default on)\n"
+              << "  --queries N      update the geodetic index and run N random 50 km queries per step\n"
+              << "  --drag CD        give the rocks and satellites US1976 drag with this coefficient\n"
+              << "  --satellites N   number of orbiting bodies to spawn (default 0)\n"
+              << "  --gravity FILE   gravity coefficient file for the satellites (default built-in J2)\n"
+              << "  --degree N       harmonic degree used from the file (default all)\n"
+              << "  --kepler KM      altitude above which satellites coast on a conic, or off (default 1000)\n"
+              << "  --event KM       count crossings of this altitude, may be given more than once\n"
+              << "  --dt S           simulated seconds per step (default 1/60)\n"
+              << "  --duration S     simulated seconds to run (default 60)\n"
+              << "  --report S       print progress every S simulated seconds\n"
+              << "  --seed N         random seed for the initial states (default 1)\n"
+              << "  --trace N        write the first N steps to trace.json as a Chrome trace\n"
+              << "  --perf B         on|off report hardware counters of the step (default off)\n"
+              << "  --scaling N      sweep 1e3, 1e4 .. N bodies over 1, 2, 4 .. --threads threads instead, sleep off\n"
+              << "  --threads N      threads stepping the bodies (default all hardware threads)\n"
+              << "  --integrator I   " << Integrators::names() << " (default euler)\n"
+              << "  --tol T          rk45 local error tolerance (default 1e-6)\n";
+}
+
+static bool parseOptions(int argc, char **argv, HeadlessOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (i + 1 >= argc)
+        {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        try
+        {
+            if (arg == "--bodies")
+                options.bodies = std::stoul(value);
+            else if (arg == "--collisions")
+                options.collisions = value == "on";
+            else if (arg == "--sleep")
+                options.sleep = value == "on";
+            else if (arg == "--queries")
+                options.queries = std::stoul(value);
+            else if (arg == "--drag")
+                options.drag = std::stod(value);
+            else if (arg == "--satellites")
+                options.satellites = std::stoul(value);
+            else if (arg == "--gravity")
+                options.gravityFile = value;
+            else if (arg == "--degree")
+                options.degree = std::stoi(value);
+            else if (arg == "--kepler")
+                options.keplerAltitude = value == "off" ? 0.0 : std::stod(value) * 1000.0;
+            else if (arg == "--event")
+                options.eventAltitudes.push_back(std::stod(value) * 1000.0);
+            else if (arg == "--dt")
+                options.deltaTime = std::stod(value);
+            else if (arg == "--duration")
+                options.duration = std::stod(value);
+            else if (arg == "--report")
+                options.reportInterval = std::stod(value);
+            else if (arg == "--seed")
+                options.seed = std::stoul(value);
+            else if (arg == "--trace")
+                options.traceSteps = std::stoul(value);
+            else if (arg == "--perf")
+                options.perf = value == "on";
+            else if (arg == "--scaling")
+                options.scalingBodies = std::stoul(value);
+            else if (arg == "--threads")
+                options.threads = std::stoul(value);
+            else if (arg == "--tol")
+            {
+                options.tolerance = std::stod(value);
+                if (!(options.tolerance > 0.0))
+                {
+                    std::cerr << "tolerance must be positive : " << value << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "--integrator")
+            {
+                if (!Integrators::parse(value, options.integrator))
+                {
+                    std::cerr << "unknown integrator " << value << std::endl;
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "unknown option " << arg << std::endl;
+                return false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "invalid value for " << arg << " : " << value << std::endl;
+            return false;
+        }
+    }
+    return options.deltaTime > 0.0;
+}
+
+// spawns bodies above the surface with random ballistic velocities
+static void spawnBodies(BodyStore &bodies, const HeadlessOptions &options)
+{
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+    std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+    std::uniform_real_distribution<double> altitude(0.1, 10.0);
+    std::uniform_real_distribution<double> speed(-1.0, 1.0);
+
+    bodies.reserve(options.bodies);
+    for (size_t i = 0; i < options.bodies; i++)
+    {
+        glm::vec3 pos = WGS84::toCartesian(latitude(rng), longitude(rng), altitude(rng));
+        glm::vec3 vel(speed(rng), speed(rng), speed(rng));
+        BodyHandle body = bodies.create(pos, vel, 1.0);
+        if (options.drag > 0.0)
+            bodies.setForceModel(body, ForceModels::Atmospheric(GravityForce(), DragForce(options.drag)));
+        else
+            RockForces::set(bodies, body);
+    }
+}
+
+// spawns bodies on roughly circular orbits between 300 and 2000 km
+static void spawnSatellites(BodyStore &bodies, const HeadlessOptions &options)
+{
+    std::mt19937 rng(options.seed + 1);
+    std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+    std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+    std::uniform_real_distribution<double> altitude(300e3 * WGS84::UnitToMeterRatio, 2000e3 * WGS84::UnitToMeterRatio);
+    std::uniform_real_distribution<double> heading(0.0, 2.0 * M_PI);
+
+    bodies.reserve(bodies.size() + options.satellites);
+    for (size_t i = 0; i < options.satellites; i++)
+    {
+        glm::dvec3 pos(WGS84::toCartesian(latitude(rng), longitude(rng), altitude(rng)));
+        // circular speed along a random direction of the local horizontal
+        glm::dvec3 up = glm::normalize(pos);
+        glm::dvec3 east = glm::normalize(glm::cross(glm::dvec3(0.0, 0.0, 1.0), up));
+        glm::dvec3 north = glm::cross(up, east);
+        double angle = heading(rng);
+        double speed = std::sqrt(WGS84::GM / glm::length(pos));
+        glm::dvec3 vel = speed * (std::cos(angle) * east + std::sin(angle) * north);
+
+        BodyHandle body = bodies.create(glm::vec3(pos), glm::vec3(vel), 1.0);
+        if (options.drag > 0.0)
+            bodies.setForceModel(body, ForceModels::OrbitalDrag(HarmonicGravityForce(), DragForce(options.drag)));
+        else
+            bodies.setForceModel(body, ForceModels::Orbital(HarmonicGravityForce()));
+    }
+}
+
+static size_t countGrounded(const BodyStore &bodies)
+{
+    size_t grounded = 0;
+    for (size_t i = 0; i < bodies.size(); i++)
+        if (bodies.alt[i] <= 0)
+            grounded++;
+    return grounded;
+}
+
+// meters of the body furthest under the ellipsoid, 0 when none is
+static double deepestBody(const BodyStore &bodies)
+{
+    double deepest = 0.0;
+    for (size_t i = 0; i < bodies.size(); i++)
+        deepest = std::min(deepest, bodies.alt[i]);
+    return deepest / WGS84::UnitToMeterRatio;
+}
+
+static double meanStepSize(const BodyStore &bodies)
+{
+    double total = 0.0;
+    size_t airborne = 0;
+    for (size_t i = 0; i < bodies.size(); i++)
+        if (bodies.alt[i] > 0)
+        {
+            total += bodies.stepSize[i];
+            airborne++;
+        }
+    return airborne > 0 ? total / airborne : 0.0;
+}
+
+/*
+    throughput of the step as the bodies and threads grow
+
+    every run spawns its rocks from the same seed and steps them for the
+    sim duration, timing only the steps (with collisions if they are on).
+    efficiency is the throughput per thread against one thread at the same
+    body count. bytes/body is what the BodyStore and Collisions hold divided
+    by the bodies, body counts go up so the kept capacity matches the run
+*/
+static int runScaling(const HeadlessOptions &options)
+{
+    Utils::JobSystem *jobs = Utils::JobSystem::getInstance();
+    BodyStore *bodies = BodyStore::getInstance();
+    Collisions *collisions = Collisions::getInstance();
+    EventQueue *events = EventQueue::getInstance();
+
+    size_t maxThreads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+    std::vector<size_t> bodyCounts;
+    for (size_t count = 1000; count < options.scalingBodies; count *= 10)
+        bodyCounts.push_back(count);
+    bodyCounts.push_back(options.scalingBodies);
+
+    // every spawned body is stepped every step, landed rocks falling asleep would make
+    // the rate depend on --duration instead of the step's throughput
+    bodies->setSleepEnabled(false);
+
+    size_t steps = static_cast<size_t>(options.duration / options.deltaTime);
+    std::cout << "scaling : " << steps << " steps x " << options.deltaTime << " s, "
+              << Integrators::name(options.integrator) << ", collisions " << (options.collisions ? "on" : "off") << "\n";
+    std::cout << std::setw(10) << "bodies" << std::setw(9) << "threads" << std::setw(16) << "body-steps/s"
+              << std::setw(12) << "efficiency" << std::setw(12) << "bytes/body" << std::endl;
+
+    for (size_t count : bodyCounts)
+    {
+        double single = 0.0;
+        for (size_t threads : threadCounts)
+        {
+            jobs->setThreadCount(threads);
+            bodies->clear();
+            HeadlessOptions run = options;
+            run.bodies = count;
+            spawnBodies(*bodies, run);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t s = 0; s < steps; s++)
+            {
+                bodies->step(options.deltaTime);
+                collisions->step(*bodies);
+                events->clear();
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double wallSeconds = std::chrono::duration<double>(end - start).count();
+            double rate = wallSeconds > 0.0 ? static_cast<double>(steps) * count / wallSeconds : 0.0;
+            if (threads == 1)
+                single = rate;
+            double efficiency = single > 0.0 ? rate / (single * threads) : 0.0;
+            double bytes = static_cast<double>(bodies->memoryUsage() + collisions->memoryUsage()) / count;
+            std::cout << std::setw(10) << count << std::setw(9) << threads << std::setw(16) << std::setprecision(4) << rate
+                      << std::setw(12) << std::setprecision(3) << efficiency << std::setw(12) << std::setprecision(4) << bytes
+                      << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    HeadlessOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    Utils::JobSystem *jobs = Utils::JobSystem::getInstance();
+    if (options.threads > 0)
+        jobs->setThreadCount(options.threads);
+
+    BodyStore *bodies = BodyStore::getInstance();
+    bodies->setDefaultIntegrator(options.integrator, true);
+    bodies->setTolerance(options.tolerance);
+    bodies->setKeplerAltitude(options.keplerAltitude);
+    bodies->setSleepEnabled(options.sleep);
+    for (double meters : options.eventAltitudes)
+        bodies->addAltitudeEvent(meters);
+    if (!options.gravityFile.empty() && !GravityField::getInstance()->load(options.gravityFile, options.degree))
+        return EXIT_FAILURE;
+    if (options.gravityFile.empty() && options.degree >= 0)
+        GravityField::getInstance()->setDegree(options.degree);
+    Collisions *collisions = Collisions::getInstance();
+    collisions->setEnabled(options.collisions);
+    PerfCounters::getInstance()->setEnabled(options.perf);
+    if (options.scalingBodies > 0)
+        return runScaling(options);
+    spawnBodies(*bodies, options);
+    spawnSatellites(*bodies, options);
+    size_t contacts = 0;
+    EventQueue *events = EventQueue::getInstance();
+    size_t impacts = 0, crossings = 0;
+    GeoIndex *geoIndex = GeoIndex::getInstance();
+    std::mt19937 queryRng(options.seed + 2);
+    std::vector<BodyHandle> found;
+    size_t hits = 0;
+    double updateSeconds = 0.0, querySeconds = 0.0;
+
+    size_t steps = static_cast<size_t>(options.duration / options.deltaTime);
+    double simTime = 0.0;
+    double nextReport = options.reportInterval;
+
+    Trace *trace = Trace::getInstance();
+#ifdef EARTH_SIM_TRACE
+    trace->capture(std::min(options.traceSteps, steps), "trace.json");
+#else
+    if (options.traceSteps > 0)
+        std::cerr << "tracing is not built in, configure with EARTH_SIM_TRACE=ON" << std::endl;
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t s = 0; s < steps; s++)
+    {
+        bodies->step(options.deltaTime);
+        collisions->step(*bodies);
+        contacts += collisions->getContacts().size();
+        BodyEvent event;
+        while (events->poll(event))
+            (event.kind == BodyEvent::Kind::Impact ? impacts : crossings)++;
+        if (options.queries > 0)
+        {
+            auto indexStart = std::chrono::steady_clock::now();
+            bodies->syncConics();
+            geoIndex->update(*bodies);
+            auto queryStart = std::chrono::steady_clock::now();
+            std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+            std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+            for (size_t q = 0; q < options.queries; q++)
+            {
+                geoIndex->radius(latitude(queryRng), longitude(queryRng), 50.0, found);
+                hits += found.size();
+            }
+            auto queryEnd = std::chrono::steady_clock::now();
+            updateSeconds += std::chrono::duration<double>(queryStart - indexStart).count();
+            querySeconds += std::chrono::duration<double>(queryEnd - queryStart).count();
+        }
+        simTime += options.deltaTime;
+        trace->frame();
+
+        if (options.reportInterval > 0.0 && simTime >= nextReport)
+        {
+            nextReport += options.reportInterval;
+            std::cout << "t=" << simTime << "s grounded=" << countGrounded(*bodies) << "/" << bodies->size()
+                      << " sleeping=" << bodies->size() - bodies->getActiveCount() << std::endl;
+        }
+    }
+    bodies->syncConics();
+    auto end = std::chrono::steady_clock::now();
+
+    double wallSeconds = std::chrono::duration<double>(end - start).count();
+    double bodySteps = static_cast<double>(steps) * bodies->size();
+
+    std::ostringstream oss;
+    oss << "bodies        : " << bodies->size() << "\n";
+    oss << "threads       : " << jobs->getThreadCount() << "\n";
+    if (options.satellites > 0)
+        oss << "gravity       : " << GravityField::getInstance()->getSource() << " degree "
+            << GravityField::getInstance()->getDegree() << "\n";
+    if (options.satellites > 0 && options.keplerAltitude > 0.0)
+        oss << "on a conic    : " << bodies->getConicCount() << " above " << options.keplerAltitude / 1000.0 << " km\n";
+    oss << "integrator    : " << Integrators::name(options.integrator) << "\n";
+    oss << "steps         : " << steps << " x " << options.deltaTime << " s\n";
+    oss << "sim time      : " << simTime << " s\n";
+    oss << "wall time     : " << wallSeconds << " s\n";
+    if (wallSeconds > 0.0)
+    {
+        oss << "steps/s       : " << steps / wallSeconds << "\n";
+        oss << "body-steps/s  : " << bodySteps / wallSeconds << "\n";
+        oss << "sim speedup   : " << simTime / wallSeconds << "x\n";
+    }
+    if (bodySteps > 0.0)
+        oss << "ns/body-step  : " << wallSeconds * 1e9 / bodySteps << "\n";
+    oss << "grounded      : " << countGrounded(*bodies) << "\n";
+    oss << "impacts       : " << impacts << ", deepest body " << -deepestBody(*bodies) << " m under ground\n";
+    if (!options.eventAltitudes.empty())
+        oss << "crossings     : " << crossings << "\n";
+    if (options.sleep)
+        oss << "sleeping      : " << bodies->size() - bodies->getActiveCount() << "\n";
+    if (options.collisions)
+        oss << "contacts      : " << contacts << " over the run\n";
+    if (options.queries > 0 && steps > 0)
+    {
+        double queryCount = static_cast<double>(steps) * options.queries;
+        oss << "index update  : " << updateSeconds * 1e9 / bodySteps << " ns/body\n";
+        oss << "50 km query   : " << querySeconds * 1e6 / queryCount << " us, " << hits / queryCount << " bodies\n";
+    }
+    if (options.integrator == Integrator::DormandPrince)
+        oss << "rk45 sub step : " << meanStepSize(*bodies) << " s mean over airborne bodies\n";
+    if (options.perf)
+        oss << PerfCounters::getInstance()->report() << "\n";
+    std::cout << oss.str() << std::endl;
+
+    return EXIT_SUCCESS;
+}
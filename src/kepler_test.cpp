@@ -0,0 +1,78 @@
+#include "Utils/BodyStore.hpp"
+#include "Utils/GravityField.hpp"
+#include "Utils/Kepler.hpp"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+// checks the conic fast path against the RK4 integrator on a point mass field, exits 1 when it drifts
+static double distance(const double a[3], const double b[3])
+{
+    return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+static double length(const double a[3])
+{
+    return std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+}
+
+int main() {
+    std::ostringstream oss;
+    bool passed = true;
+    const double mu = WGS84::GM;
+    const double toMeters = 1.0 / WGS84::UnitToMeterRatio;
+
+    // central term only, so the numerical orbit is the same two body problem as the conic
+    GravityField::getInstance()->setDegree(0);
+    BodyStore *bodies = BodyStore::getInstance();
+    bodies->setKeplerAltitude(0.0);
+    bodies->setSleepEnabled(false);
+
+    // an eccentric orbit starting at its perigee, 7000 km from the center
+    BodyHandle body = bodies->create(glm::vec3(7000e3 * WGS84::UnitToMeterRatio, 0.f, 0.f), glm::vec3(0.f, 0.8f, 0.1f), 1.0);
+    bodies->setForceModel(body, ForceModels::Orbital(HarmonicGravityForce()));
+    bodies->setIntegrator(body, Integrator::RK4);
+    double r0[3] = {bodies->x[0], bodies->y[0], bodies->z[0]};
+    double v0[3] = {bodies->vx[0], bodies->vy[0], bodies->vz[0]};
+
+    double speed2 = v0[0] * v0[0] + v0[1] * v0[1] + v0[2] * v0[2];
+    double semiMajor = 1.0 / (2.0 / length(r0) - speed2 / mu);
+    double period = 2.0 * M_PI * std::sqrt(semiMajor * semiMajor * semiMajor / mu);
+
+    // Testing one period against RK4
+    const int steps = 10000;
+    for (int s = 0; s < steps; s++)
+        bodies->step(period / steps);
+    double numeric[3] = {bodies->x[0], bodies->y[0], bodies->z[0]};
+    double r[3], v[3];
+    Kepler::propagate(r0, v0, mu, period, r, v);
+    double drift = distance(r, numeric) * toMeters;
+    oss << "period " << period << " s, kepler - rk4 after one period: " << drift << " m\n";
+    passed &= drift < 1.0;
+
+    // Testing timeToRadius round trip, from the apogee down to halfway between perigee and apogee
+    double apogee[3], apogeeVelocity[3];
+    Kepler::propagate(r0, v0, mu, period / 2.0, apogee, apogeeVelocity);
+    double radius = 0.5 * (length(r0) + length(apogee));
+    double t = Kepler::timeToRadius(apogee, apogeeVelocity, mu, radius);
+    Kepler::propagate(apogee, apogeeVelocity, mu, t, r, v);
+    double radialSpeed = (r[0] * v[0] + r[1] * v[1] + r[2] * v[2]) / length(r);
+    double missed = std::fabs(length(r) - radius) * toMeters;
+    double back[3], backVelocity[3];
+    Kepler::propagate(r, v, mu, -t, back, backVelocity);
+    double roundTrip = distance(back, apogee) * toMeters;
+    oss << "timeToRadius " << t << " s, radius off by " << missed << " m, radial speed " << radialSpeed
+        << " u/s, back to the apogee within " << roundTrip << " m\n";
+    passed &= t > 0.0 && t < period / 2.0 && missed < 1e-3 && radialSpeed < 0.0 && roundTrip < 1e-3;
+
+    // Testing a radius below the perigee, never reached
+    double never = Kepler::timeToRadius(r0, v0, mu, 0.9 * length(r0));
+    oss << "timeToRadius below the perigee: " << never << "\n";
+    passed &= never == std::numeric_limits<double>::infinity();
+
+    oss << (passed ? "passed" : "FAILED");
+    std::cout << oss.str() << std::endl;
+
+    return passed ? 0 : 1;
+}
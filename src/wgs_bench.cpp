@@ -0,0 +1,146 @@
+#include "static/wgs84.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/*
+    accuracy and speed of every WGS84::GeodeticMethod
+
+    random points are built from known geodetic coordinates, converted to ECEF,
+    converted back with each method and turned into ECEF again. the error is the
+    3D distance between the two ECEF points in meters, so latitude and height
+    errors are measured on the same scale
+*/
+
+struct Points {
+    std::vector<double> lat, lon, alt;
+    std::vector<double> x, y, z;
+};
+
+static Points makePoints(size_t count, double minHeight, double maxHeight, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+    std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+    std::uniform_real_distribution<double> height(minHeight, maxHeight);
+
+    Points points;
+    for (auto column : {&points.lat, &points.lon, &points.alt, &points.x, &points.y, &points.z})
+        column->resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        points.lat[i] = latitude(rng);
+        points.lon[i] = longitude(rng);
+        points.alt[i] = height(rng);
+    }
+    WGS84::toCartesian(points.lat.data(), points.lon.data(), points.alt.data(),
+                       points.x.data(), points.y.data(), points.z.data(), count);
+    return points;
+}
+
+struct Result {
+    double nsPerConversion;
+    double maxErrorMeters;
+    double meanErrorMeters;
+};
+
+static Result measure(const Points &points, WGS84::GeodeticMethod method)
+{
+    size_t count = points.x.size();
+    std::vector<WGS84::GeodeticPosition> out(count);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        out[i] = WGS84::toGeodetic(points.x[i], points.y[i], points.z[i], method);
+    auto end = std::chrono::steady_clock::now();
+
+    std::vector<double> lat(count), lon(count), alt(count), x(count), y(count), z(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        lat[i] = out[i].latitude;
+        lon[i] = out[i].longitude;
+        alt[i] = out[i].height;
+    }
+    WGS84::toCartesian(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+
+    Result result{std::chrono::duration<double, std::nano>(end - start).count() / count, 0.0, 0.0};
+    for (size_t i = 0; i < count; i++)
+    {
+        double dx = x[i] - points.x[i], dy = y[i] - points.y[i], dz = z[i] - points.z[i];
+        double error = std::sqrt(dx * dx + dy * dy + dz * dz) / WGS84::UnitToMeterRatio;
+        result.maxErrorMeters = std::max(result.maxErrorMeters, error);
+        result.meanErrorMeters += error / count;
+    }
+    return result;
+}
+
+static Result measureBatch(const Points &points)
+{
+    size_t count = points.x.size();
+    std::vector<double> lon(count), lat(count), alt(count), x(count), y(count), z(count);
+
+    auto start = std::chrono::steady_clock::now();
+    WGS84::toGeodetic(points.x.data(), points.y.data(), points.z.data(), lon.data(), lat.data(), alt.data(), count);
+    auto end = std::chrono::steady_clock::now();
+
+    WGS84::toCartesian(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+
+    Result result{std::chrono::duration<double, std::nano>(end - start).count() / count, 0.0, 0.0};
+    for (size_t i = 0; i < count; i++)
+    {
+        double dx = x[i] - points.x[i], dy = y[i] - points.y[i], dz = z[i] - points.z[i];
+        double error = std::sqrt(dx * dx + dy * dy + dz * dz) / WGS84::UnitToMeterRatio;
+        result.maxErrorMeters = std::max(result.maxErrorMeters, error);
+        result.meanErrorMeters += error / count;
+    }
+    return result;
+}
+
+static void printRow(const std::string &name, const Result &result, double documented)
+{
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(2) << result.nsPerConversion
+              << std::setw(14) << std::scientific << std::setprecision(2) << result.maxErrorMeters
+              << std::setw(14) << result.meanErrorMeters;
+    if (documented > 0.0)
+        std::cout << std::setw(14) << documented;
+    std::cout << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const double km = 1000.0 * WGS84::UnitToMeterRatio;
+
+    // same bands as the error table in wgs84.hpp
+    struct Band {
+        const char *name;
+        double minHeight, maxHeight;
+    };
+    const Band bands[] = {
+        {"surface   -10 km .. 10 km", -10 * km, 10 * km},
+        {"low orbit  10 km .. 2000 km", 10 * km, 2000 * km},
+        {"high orbit 2000 km .. 36000 km", 2000 * km, 36000 * km},
+    };
+    const WGS84::GeodeticMethod methods[] = {WGS84::GeodeticMethod::Bowring, WGS84::GeodeticMethod::Zhu,
+                                             WGS84::GeodeticMethod::Vermeille, WGS84::GeodeticMethod::Newton};
+
+    std::cout << count << " points per band, batch width " << WGS84::batchWidth() << "\n";
+    for (const auto &band : bands)
+    {
+        Points points = makePoints(count, band.minHeight, band.maxHeight, 42);
+        std::cout << "\n" << band.name << "\n";
+        std::cout << std::left << std::setw(16) << "method" << std::right << std::setw(12) << "ns/conv"
+                  << std::setw(14) << "max err m" << std::setw(14) << "mean err m" << std::setw(14) << "documented" << "\n";
+        double maxHeightMeters = band.maxHeight / WGS84::UnitToMeterRatio;
+        for (auto method : methods)
+            printRow(WGS84::geodeticMethodName(method), measure(points, method), WGS84::geodeticMaxError(method, maxHeightMeters));
+        printRow("bowring batch", measureBatch(points), WGS84::geodeticMaxError(WGS84::GeodeticMethod::Bowring, maxHeightMeters));
+    }
+    std::cout << std::endl;
+    return 0;
+}